@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rsa.h"
+#include "timing.h"
+
+// Мікробенчмарк ядер: нс на mulmod і на modexp для кожного варіанта ядра,
+// кількох розмірів модуля та довжин експоненти. Кожен вимір — серія
+// прогонів після розігріву, звіт — медіана, p10, p90 та мінімум.
+//
+//   bench_kernels [--reps=N] [--warmup=N] [--ops=N] [--csv]
+
+#define MULMOD_PER_OP 64    // mulmod вимірюється ланцюжком, у стільки разів довшим за modexp
+
+typedef struct {
+    int bits;
+    ull n;
+} bench_modulus;
+
+typedef struct {
+    int bits;
+    ull e;
+} bench_exponent;
+
+// Непарні модулі: найбільше просте < 2^32 (розмір p і q у CRT),
+// 48-бітне та n_const драйверів
+static const bench_modulus moduli[] = {
+    {32, 4294967291ULL},
+    {48, 281474976710597ULL},
+    {63, 9000000054000000077ULL},
+};
+
+static const bench_exponent exponents[] = {
+    {17, 65537ULL},
+    {32, 0xF1234567ULL},
+    {50, 900000000000000ULL},
+    {63, 0x7A5C3E1F2B4D6987ULL},
+};
+
+typedef struct {
+    const char *op;
+    const char *kernel;
+    int ilp;
+    int mod_bits, exp_bits;
+    double median, p10, p90, min;
+    int exact;
+} bench_result;
+
+static int reps = 15, warmup = 3, ops = 20000, csv = 0;
+static volatile ull sink;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double p) {
+    int idx = (int) (p * (count - 1) + 0.5);
+    return sorted[idx];
+}
+
+static void summarize(bench_result *r, double *samples) {
+    qsort(samples, reps, sizeof(double), cmp_double);
+    r->median = percentile(samples, reps, 0.5);
+    r->p10 = percentile(samples, reps, 0.1);
+    r->p90 = percentile(samples, reps, 0.9);
+    r->min = samples[0];
+}
+
+static void print_header(void) {
+    if (csv)
+        printf("op,kernel,ilp,mod_bits,exp_bits,ops,reps,median_ns,p10_ns,p90_ns,min_ns,exact\n");
+    else
+        printf("%-7s %-8s %3s %4s %4s %10s %10s %10s %10s %6s\n",
+               "op", "kernel", "ilp", "mod", "exp", "median", "p10", "p90", "min", "exact");
+}
+
+static void print_result(const bench_result *r) {
+    if (csv)
+        printf("%s,%s,%d,%d,%d,%d,%d,%.2f,%.2f,%.2f,%.2f,%d\n",
+               r->op, r->kernel, r->ilp, r->mod_bits, r->exp_bits, ops, reps,
+               r->median, r->p10, r->p90, r->min, r->exact);
+    else
+        printf("%-7s %-8s %3d %4d %4d %10.2f %10.2f %10.2f %10.2f %6s\n",
+               r->op, r->kernel, r->ilp, r->mod_bits, r->exp_bits,
+               r->median, r->p10, r->p90, r->min, r->exact ? "yes" : "no");
+}
+
+// --- mulmod: залежний ланцюжок x = x * y mod n, тобто затримка одного множення ---
+
+typedef enum { MUL_LEGACY, MUL_U128, MUL_BARRETT, MUL_MONT, MUL_SIMD } mul_variant;
+
+static const char *mul_names[] = {"legacy", "u128", "barrett", "mont", "simd"};
+
+static ull mulmod_chain(mul_variant v, const bench_modulus *m, ull x, ull y, long count) {
+    barrett_ctx barrett;
+    mont_ctx mont = {0};        // mont_init не заповнює контекст для парного чи 64-бітного n
+    barrett_init(&barrett, m->n);
+    mont_init(&mont, m->n);
+    switch (v) {
+        case MUL_LEGACY:
+            for (long k = 0; k < count; k++) x = (x * y) % m->n;
+            break;
+        case MUL_U128:
+            for (long k = 0; k < count; k++) x = mulmod_u128(x, y, m->n);
+            break;
+        case MUL_BARRETT:
+            for (long k = 0; k < count; k++) x = mulmod_barrett(&barrett, x, y);
+            break;
+        default:
+            for (long k = 0; k < count; k++) x = mont_mul(&mont, x, y);
+            break;
+    }
+    return x;
+}
+
+#if defined(__x86_64__)
+// Чотири лани за раз; час ділиться на кількість елементів
+__attribute__((target("avx2")))
+static ull mulmod_chain_simd(const bench_modulus *m, ull x, ull y, long count) {
+    ull inv = m->n;
+    for (int i = 0; i < 4; i++) inv *= 2 - m->n * inv;
+    __m256i n = _mm256_set1_epi64x((ll) m->n);
+    __m256i ninv = _mm256_set1_epi64x((ll) ((0 - inv) & 0xffffffffULL));
+    __m256i vx = _mm256_set_epi64x((ll) x, (ll) (x ^ 1), (ll) (x ^ 2), (ll) (x ^ 3));
+    __m256i vy = _mm256_set1_epi64x((ll) y);
+    for (long k = 0; k < count / SIMD_LANES; k++) vx = mont32_mul_avx2(vx, vy, n, ninv);
+    ull out[SIMD_LANES];
+    _mm256_storeu_si256((__m256i *) out, vx);
+    return out[0] ^ out[1] ^ out[2] ^ out[3];
+}
+#endif
+
+static int simd_available(const bench_modulus *m) {
+#if defined(__x86_64__)
+    return m->bits <= 32 && __builtin_cpu_supports("avx2");
+#else
+    (void) m;
+    return 0;
+#endif
+}
+
+static void bench_mulmod(mul_variant v, const bench_modulus *m) {
+    bench_result r = {"mulmod", mul_names[v], 1, m->bits, 0, 0, 0, 0, 0, 1};
+    long count = (long) ops * MULMOD_PER_OP;
+    ull x = m->n / 3, y = m->n / 7 + 5;
+    double *samples = malloc(reps * sizeof(double));
+
+    for (int rep = -warmup; rep < reps; rep++) {
+        double t0 = wall_now();
+#if defined(__x86_64__)
+        if (v == MUL_SIMD)
+            sink = mulmod_chain_simd(m, x, y, count);
+        else
+#endif
+            sink = mulmod_chain(v, m, x, y, count);
+        double t1 = wall_now();
+        if (rep >= 0) samples[rep] = (t1 - t0) * 1e9 / count;
+    }
+
+    // legacy точний лише поки добуток вміщується у 64 біти
+    ull expect = mulmod_u128(x, y, m->n);
+    if (v == MUL_LEGACY) r.exact = ((x * y) % m->n) == expect;
+    summarize(&r, samples);
+    print_result(&r);
+    free(samples);
+}
+
+// --- modexp: незалежні повідомлення, тобто пропускна здатність ядра ---
+
+static void run_modexp(const modexp_plan *plan, int use_simd, const ull *msg, ull *out) {
+#if defined(__x86_64__)
+    if (use_simd) {
+        for (int k = 0; k + SIMD_LANES <= ops; k += SIMD_LANES)
+            modexp32_avx2(msg + k, out + k, plan->e, plan->n);
+        return;
+    }
+#else
+    (void) use_simd;
+#endif
+    for (int k = 0; k < ops; k += plan->ilp) {
+        int count = ops - k < plan->ilp ? ops - k : plan->ilp;
+        plan_modexp_batch(plan, msg + k, out + k, count);
+    }
+}
+
+static double bench_modexp(grid_kernel kernel, int ilp, int use_simd,
+                           const bench_modulus *m, const bench_exponent *x) {
+    modexp_plan plan;
+    if (modexp_plan_init(&plan, kernel, m->n, x->e) != 0) return 0.0;
+    plan.ilp = ilp;
+
+    bench_result r = {"modexp", use_simd ? "simd" : grid_kernel_name(kernel),
+                      use_simd ? SIMD_LANES : ilp, m->bits, x->bits, 0, 0, 0, 0, 1};
+    ull *msg = malloc(ops * sizeof(ull));
+    ull *out = calloc(ops, sizeof(ull));
+    double *samples = malloc(reps * sizeof(double));
+    for (int k = 0; k < ops; k++)
+        msg[k] = ((ull) k * 0x9E3779B97F4A7C15ULL) % m->n;
+
+    for (int rep = -warmup; rep < reps; rep++) {
+        double t0 = wall_now();
+        run_modexp(&plan, use_simd, msg, out);
+        double t1 = wall_now();
+        if (rep >= 0) samples[rep] = (t1 - t0) * 1e9 / ops;
+    }
+
+    for (int k = 0; k < ops; k += ops / 64 + 1)
+        if (out[k] != modexp_u128(msg[k], x->e, m->n)) r.exact = 0;
+    sink = out[ops - 1];
+
+    summarize(&r, samples);
+    print_result(&r);
+    free(msg);
+    free(out);
+    free(samples);
+    return r.median;
+}
+
+int main(int argc, char *argv[]) {
+    for (int a = 1; a < argc; a++) {
+        if (strncmp(argv[a], "--reps=", 7) == 0) reps = atoi(argv[a] + 7);
+        else if (strncmp(argv[a], "--warmup=", 9) == 0) warmup = atoi(argv[a] + 9);
+        else if (strncmp(argv[a], "--ops=", 6) == 0) ops = atoi(argv[a] + 6);
+        else if (strcmp(argv[a], "--csv") == 0) csv = 1;
+        else {
+            fprintf(stderr, "Використання: %s [--reps=N] [--warmup=N] [--ops=N] [--csv]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (reps < 1 || warmup < 0 || ops < SIMD_LANES) {
+        fprintf(stderr, "Некоректні параметри вимірювання\n");
+        return 1;
+    }
+
+    const int n_moduli = sizeof(moduli) / sizeof(moduli[0]);
+    const int n_exponents = sizeof(exponents) / sizeof(exponents[0]);
+    const grid_kernel kernels[] = {KERNEL_LEGACY, KERNEL_U128, KERNEL_BARRETT, KERNEL_MONT, KERNEL_CT};
+    const int ilps[] = {1, 4, 8};
+
+    print_header();
+    for (int mi = 0; mi < n_moduli; mi++) {
+        for (mul_variant v = MUL_LEGACY; v <= MUL_SIMD; v++) {
+            if (v == MUL_SIMD && !simd_available(&moduli[mi])) continue;
+            bench_mulmod(v, &moduli[mi]);
+        }
+    }
+
+    // Ціна сталочасового режиму на модулі та експоненті драйверів
+    double fast = 0.0, ct = 0.0;
+    for (int mi = 0; mi < n_moduli; mi++) {
+        for (int xi = 0; xi < n_exponents; xi++) {
+            const bench_modulus *m = &moduli[mi];
+            const bench_exponent *x = &exponents[xi];
+            for (int ki = 0; ki < 5; ki++) {
+                for (int li = 0; li < 3; li++) {
+                    double t = bench_modexp(kernels[ki], ilps[li], 0, m, x);
+                    if (m->bits != 63 || x->bits != 50 || kernels[ki] == KERNEL_LEGACY) continue;
+                    if (kernels[ki] == KERNEL_CT) {
+                        if (ct == 0.0 || t < ct) ct = t;
+                    } else if (fast == 0.0 || t < fast) {
+                        fast = t;
+                    }
+                }
+            }
+            if (simd_available(m))
+                bench_modexp(KERNEL_MONT, 1, 1, m, x);
+        }
+    }
+
+    fprintf(csv ? stderr : stdout,
+            "\nЦіна сталочасового режиму (63-бітний n, 50-бітна e): "
+            "ct %.1f нс проти найшвидшого точного ядра %.1f нс, x%.2f\n",
+            ct, fast, ct / fast);
+    return 0;
+}
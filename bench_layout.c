@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "gridlayout.h"
+#include "timing.h"
+
+// Бенчмарк розкладок сітки: пропускна здатність паралельного перетворювача
+// з построкової розкладки і назад, а також вартість читання випадкових
+// квадратних областей — скільки різних кеш-ліній і сторінок вони торкаються
+// і скільки часу займає сума клітинок області.
+//
+//   bench_layout [--size=WxH] [--tile=T] [--region=R] [--queries=N] [--threads=N] [--csv]
+
+#define LINE_BYTES 64
+#define PAGE_BYTES 4096
+
+static int width = 3000, height = 3000, tile = LAYOUT_TILE_DEFAULT, region = 32;
+static int queries = 20000, threads = 0, csv = 0;
+static volatile ull sink;
+
+static int cmp_addr(const void *a, const void *b) {
+    size_t x = *(const size_t *) a, y = *(const size_t *) b;
+    return (x > y) - (x < y);
+}
+
+static int count_unique(size_t *v, int count) {
+    qsort(v, count, sizeof(size_t), cmp_addr);
+    int unique = 0;
+    for (int k = 0; k < count; k++)
+        if (k == 0 || v[k] != v[k - 1]) unique++;
+    return unique;
+}
+
+// Лінії та сторінки, яких торкається область: адреси всіх відрізків
+static void region_footprint(const grid_layout *l, ull *data, int i0, int j0,
+                             size_t *lines, size_t *pages, int *nlines, int *npages) {
+    int nl = 0, np = 0;
+    for (int i = i0; i < i0 + region; i++) {
+        for (int j = j0; j < j0 + region;) {
+            int len;
+            ull *run = grid_layout_run(l, data, i, j, &len);
+            if (len > j0 + region - j) len = j0 + region - j;
+            size_t begin = (size_t) run, end = (size_t) (run + len) - 1;
+            for (size_t a = begin / LINE_BYTES; a <= end / LINE_BYTES; a++) lines[nl++] = a;
+            for (size_t a = begin / PAGE_BYTES; a <= end / PAGE_BYTES; a++) pages[np++] = a;
+            j += len;
+        }
+    }
+    *nlines = count_unique(lines, nl);
+    *npages = count_unique(pages, np);
+}
+
+static ull region_sum(const grid_layout *l, ull *data, int i0, int j0) {
+    ull sum = 0;
+    for (int i = i0; i < i0 + region; i++) {
+        for (int j = j0; j < j0 + region;) {
+            int len;
+            const ull *run = grid_layout_run(l, data, i, j, &len);
+            if (len > j0 + region - j) len = j0 + region - j;
+            for (int k = 0; k < len; k++) sum += run[k];
+            j += len;
+        }
+    }
+    return sum;
+}
+
+static void bench(workpool *pool, grid_layout_kind kind, const ull *rows, ull *back, const int *origins) {
+    grid_layout l;
+    if (grid_layout_init(&l, kind, width, height, tile) != 0) exit(1);
+    ull *data = malloc(grid_layout_cells(&l) * sizeof(ull));
+    if (!data) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        exit(1);
+    }
+
+    double t0 = wall_now();
+    grid_layout_convert(pool, &l, rows, data, 0);
+    double t1 = wall_now();
+    memset(back, 0, (size_t) width * height * sizeof(ull));
+    double t2 = wall_now();
+    grid_layout_convert(pool, &l, data, back, 1);
+    double t3 = wall_now();
+    int exact = memcmp(rows, back, (size_t) width * height * sizeof(ull)) == 0;
+    double gb = (double) width * height * sizeof(ull) * 2 / 1e9;   // читання + запис
+
+    size_t *lines = malloc((size_t) region * (region + 2) * 2 * sizeof(size_t));
+    size_t *pages = malloc((size_t) region * (region + 2) * 2 * sizeof(size_t));
+    long long total_lines = 0, total_pages = 0;
+    for (int q = 0; q < queries; q++) {
+        int nl, np;
+        region_footprint(&l, data, origins[2 * q], origins[2 * q + 1], lines, pages, &nl, &np);
+        total_lines += nl;
+        total_pages += np;
+    }
+    ull sum = 0;
+    double r0 = wall_now();
+    for (int q = 0; q < queries; q++) sum += region_sum(&l, data, origins[2 * q], origins[2 * q + 1]);
+    double r1 = wall_now();
+    sink = sum;
+
+    const char *name = grid_layout_name(kind);
+    int side = kind == LAYOUT_ROW ? 0 : tile;
+    if (csv)
+        printf("%s,%d,%d,%d,%.3f,%.3f,%.2f,%.2f,%.1f,%.1f,%.1f,%d\n", name, side, region, queries,
+               (t1 - t0) * 1e3, (t3 - t2) * 1e3, gb / (t1 - t0), gb / (t3 - t2),
+               (double) total_lines / queries, (double) total_pages / queries,
+               (r1 - r0) * 1e9 / queries, exact);
+    else
+        printf("%-7s %5d %10.2f %10.2f %8.2f %8.2f %9.1f %8.1f %12.1f %6s\n", name, side,
+               (t1 - t0) * 1e3, (t3 - t2) * 1e3, gb / (t1 - t0), gb / (t3 - t2),
+               (double) total_lines / queries, (double) total_pages / queries,
+               (r1 - r0) * 1e9 / queries, exact ? "yes" : "no");
+
+    free(lines);
+    free(pages);
+    free(data);
+    grid_layout_free(&l);
+}
+
+int main(int argc, char *argv[]) {
+    for (int a = 1; a < argc; a++) {
+        if (strncmp(argv[a], "--size=", 7) == 0) sscanf(argv[a] + 7, "%dx%d", &width, &height);
+        else if (strncmp(argv[a], "--tile=", 7) == 0) tile = atoi(argv[a] + 7);
+        else if (strncmp(argv[a], "--region=", 9) == 0) region = atoi(argv[a] + 9);
+        else if (strncmp(argv[a], "--queries=", 10) == 0) queries = atoi(argv[a] + 10);
+        else if (strncmp(argv[a], "--threads=", 10) == 0) threads = atoi(argv[a] + 10);
+        else if (strcmp(argv[a], "--csv") == 0) csv = 1;
+        else {
+            fprintf(stderr, "Використання: %s [--size=WxH] [--tile=T] [--region=R] [--queries=N] "
+                            "[--threads=N] [--csv]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (width < 1 || height < 1 || region < 1 || region > width || region > height || queries < 1 ||
+        threads < 0) {
+        fprintf(stderr, "Некоректні параметри вимірювання\n");
+        return 1;
+    }
+
+    if (threads == 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    workpool *pool = workpool_create(threads > 0 ? threads : 1);
+    size_t cells = (size_t) width * height;
+    ull *rows = malloc(cells * sizeof(ull));
+    ull *back = malloc(cells * sizeof(ull));
+    int *origins = malloc(2 * (size_t) queries * sizeof(int));
+    if (!pool || !rows || !back || !origins) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        return 1;
+    }
+    for (size_t k = 0; k < cells; k++) rows[k] = fmix64(k);
+    // Однакові області для всіх розкладок
+    for (int q = 0; q < queries; q++) {
+        origins[2 * q] = (int) (fmix64(2 * (ull) q + 1) % (ull) (height - region + 1));
+        origins[2 * q + 1] = (int) (fmix64(2 * (ull) q + 2) % (ull) (width - region + 1));
+    }
+
+    if (csv)
+        printf("layout,tile,region,queries,to_ms,from_ms,to_gbps,from_gbps,lines,pages,region_ns,exact\n");
+    else
+        printf("Сітка %dx%d, область %dx%d, запитів %d, потоків %d\n"
+               "%-7s %5s %10s %10s %8s %8s %9s %8s %12s %6s\n",
+               width, height, region, region, queries, workpool_size(pool),
+               "layout", "tile", "to ms", "from ms", "to GB/s", "from", "lines", "pages", "ns/region",
+               "exact");
+    bench(pool, LAYOUT_ROW, rows, back, origins);
+    bench(pool, LAYOUT_TILED, rows, back, origins);
+    bench(pool, LAYOUT_MORTON, rows, back, origins);
+
+    free(origins);
+    free(back);
+    free(rows);
+    workpool_destroy(pool);
+    return 0;
+}
@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "report.h"
+#include "timing.h"
+
+// Наскрізний бенчмарк масштабування seq, openmp, pthreads та mpi. Запускає драйвери з
+// --summary на матриці потоків, процесів і розмірів сітки, перевіряє, що
+// результати однакові (min, max, контрольні клітинки та відбиток усієї сітки), і друкує прискорення, ефективність та метрику
+// Карпа-Флатта у CSV або JSON.
+//
+// Сильне масштабування: розмір сталий, базовий час — seq на тому ж розмірі.
+// Слабке масштабування: висота росте разом з кількістю виконавців p,
+// базовий час — seq на початковому розмірі, прискорення масштабоване (p * T1 / Tp).
+
+#define MAX_LIST 32
+#define MAX_ROWS 1024
+#define CMD_LEN 1024
+
+typedef struct {
+    int width, height;
+} grid_size;
+
+typedef struct {
+    const char *mode;       // base, strong або weak
+    const char *backend;
+    int workers;
+    int width, height;
+    double seconds;         // медіана часу обчислення за звітом драйвера
+    double wall;            // медіана часу процесу разом із запуском
+    double speedup, efficiency, karp_flatt;
+    int match;              // 1 — збігається з першим запуском того ж розміру
+    grid_summary result;
+} scaling_row;
+
+static const char *bin_dir = ".";
+static const char *mpirun = "mpirun -np";
+// Драйвери за замовчуванням мають різні e та формули повідомлень,
+// тому для порівняння всі запускаються з однаковими
+static const char *formula = "diag";
+static const char *exponent = "900000000000000";
+static const char *driver_args = "";
+static int reps = 3;
+static int energy = 0;
+
+static scaling_row rows[MAX_ROWS];
+static int n_rows = 0;
+
+// Перші результати для кожного розміру — еталон для решти запусків
+static grid_summary references[MAX_ROWS];
+static int n_references = 0;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static int parse_int_list(const char *s, int *out) {
+    int count = 0;
+    while (*s && count < MAX_LIST) {
+        out[count++] = atoi(s);
+        s = strchr(s, ',');
+        if (!s) break;
+        s++;
+    }
+    return count;
+}
+
+static int parse_sizes(const char *s, grid_size *out) {
+    int count = 0;
+    while (*s && count < MAX_LIST) {
+        if (sscanf(s, "%dx%d", &out[count].width, &out[count].height) == 2) count++;
+        s = strchr(s, ',');
+        if (!s) break;
+        s++;
+    }
+    return count;
+}
+
+static int has_backend(const char *list, const char *name) {
+    size_t len = strlen(name);
+    for (const char *p = strstr(list, name); p; p = strstr(p + 1, name)) {
+        if ((p == list || p[-1] == ',') && (p[len] == ',' || p[len] == '\0')) return 1;
+    }
+    return 0;
+}
+
+// Розбирає рядок "RESULT key=value ..." з --summary
+static int parse_result(char *line, grid_summary *r) {
+    if (strncmp(line, "RESULT ", 7) != 0) return 0;
+    for (char *tok = strtok(line + 7, " \n"); tok; tok = strtok(NULL, " \n")) {
+        char *eq = strchr(tok, '=');
+        if (!eq) continue;
+        *eq = '\0';
+        const char *val = eq + 1;
+        if (strcmp(tok, "workers") == 0) r->workers = atoi(val);
+        else if (strcmp(tok, "width") == 0) r->width = atoi(val);
+        else if (strcmp(tok, "height") == 0) r->height = atoi(val);
+        else if (strcmp(tok, "seconds") == 0) r->seconds = atof(val);
+        else if (strcmp(tok, "joules") == 0) r->joules = atof(val);
+        else if (strcmp(tok, "min") == 0) r->min = strtoull(val, NULL, 10);
+        else if (strcmp(tok, "max") == 0) r->max = strtoull(val, NULL, 10);
+        else if (strcmp(tok, "fingerprint") == 0)
+            r->has_fingerprint = fingerprint_parse(val, &r->fingerprint) == 0;
+        else if (strcmp(tok, "probes") == 0)
+            sscanf(val, "%llu,%llu,%llu,%llu,%llu", &r->probes[0], &r->probes[1],
+                   &r->probes[2], &r->probes[3], &r->probes[4]);
+    }
+    return 1;
+}
+
+// Запускає драйвер reps разів; повертає 0 та медіани часу або -1
+static int run_backend(const char *backend, int workers, grid_size size,
+                       grid_summary *result, double *seconds, double *wall) {
+    char cmd[CMD_LEN], args[CMD_LEN];
+    int len = snprintf(args, sizeof(args), "--size=%dx%d --summary --checksum --formula=%s --e=%s%s %s",
+                       size.width, size.height, formula, exponent, energy ? " --energy" : "", driver_args);
+    if (len >= 0 && len < (int) sizeof(args)) {
+        if (strcmp(backend, "mpi") == 0)
+            len = snprintf(cmd, sizeof(cmd), "%s %d %s/mpi %s", mpirun, workers, bin_dir, args);
+        else if (strcmp(backend, "openmp") == 0)
+            len = snprintf(cmd, sizeof(cmd), "OMP_NUM_THREADS=%d %s/openmp %s", workers, bin_dir, args);
+        else if (strcmp(backend, "pthreads") == 0)
+            len = snprintf(cmd, sizeof(cmd), "%s/pthreads --threads=%d %s", bin_dir, workers, args);
+        else
+            len = snprintf(cmd, sizeof(cmd), "%s/seq %s", bin_dir, args);
+    }
+    // Обрізана команда запустила б щось інше, ніж задано
+    if (len < 0 || len >= CMD_LEN) {
+        fprintf(stderr, "Команда запуску %s довша за %d символів\n", backend, CMD_LEN - 1);
+        return -1;
+    }
+
+    double *compute = malloc(reps * sizeof(double));
+    double *process = malloc(reps * sizeof(double));
+    double *joules = malloc(reps * sizeof(double));
+    int ok = 0;
+    for (int rep = 0; rep < reps; rep++) {
+        double t0 = wall_now();
+        FILE *pipe = popen(cmd, "r");
+        if (!pipe) break;
+        char line[CMD_LEN];
+        int found = 0;
+        while (fgets(line, sizeof(line), pipe)) {
+            grid_summary r = {0};
+            if (parse_result(line, &r)) {
+                *result = r;
+                found = 1;
+            }
+        }
+        int status = pclose(pipe);
+        process[rep] = wall_now() - t0;
+        if (!found || status != 0) {
+            fprintf(stderr, "Запуск завершився невдало: %s\n", cmd);
+            break;
+        }
+        compute[rep] = result->seconds;
+        joules[rep] = result->joules;
+        ok++;
+    }
+
+    if (ok == reps) {
+        qsort(compute, reps, sizeof(double), cmp_double);
+        qsort(process, reps, sizeof(double), cmp_double);
+        qsort(joules, reps, sizeof(double), cmp_double);
+        *seconds = compute[reps / 2];
+        *wall = process[reps / 2];
+        result->joules = joules[reps / 2];
+    }
+    free(compute);
+    free(process);
+    free(joules);
+    return ok == reps ? 0 : -1;
+}
+
+static int results_equal(const grid_summary *a, const grid_summary *b) {
+    if (a->min != b->min || a->max != b->max) return 0;
+    if (a->has_fingerprint != b->has_fingerprint) return 0;
+    if (a->has_fingerprint && !fingerprint_equal(a->fingerprint, b->fingerprint)) return 0;
+    for (int k = 0; k < GRID_PROBES; k++)
+        if (a->probes[k] != b->probes[k]) return 0;
+    return 1;
+}
+
+static int check_reference(const grid_summary *r) {
+    for (int k = 0; k < n_references; k++)
+        if (references[k].width == r->width && references[k].height == r->height)
+            return results_equal(&references[k], r);
+    if (n_references < MAX_ROWS) references[n_references++] = *r;
+    return 1;
+}
+
+// Запускає один вимір і додає рядок таблиці; base_seconds — час seq для порівняння
+static scaling_row *measure(const char *mode, const char *backend, int workers,
+                            grid_size size, double base_seconds) {
+    if (n_rows >= MAX_ROWS) return NULL;
+    scaling_row *row = &rows[n_rows];
+    memset(row, 0, sizeof(*row));
+    row->mode = mode;
+    row->backend = backend;
+    row->workers = workers;
+    row->width = size.width;
+    row->height = size.height;
+    if (run_backend(backend, workers, size, &row->result, &row->seconds, &row->wall) != 0)
+        return NULL;
+    row->match = check_reference(&row->result);
+
+    double p = workers;
+    if (base_seconds > 0.0 && row->seconds > 0.0) {
+        if (strcmp(mode, "weak") == 0) {
+            row->efficiency = base_seconds / row->seconds;
+            row->speedup = p * row->efficiency;
+        } else {
+            row->speedup = base_seconds / row->seconds;
+            row->efficiency = row->speedup / p;
+        }
+        // Експериментально визначена послідовна частка
+        row->karp_flatt = workers > 1 ? (1.0 / row->speedup - 1.0 / p) / (1.0 - 1.0 / p) : 0.0;
+    }
+    n_rows++;
+    fprintf(stderr, "%s %s p=%d %dx%d: %.3f с%s\n", mode, backend, workers,
+            size.width, size.height, row->seconds, row->match ? "" : " РОЗБІЖНІСТЬ");
+    return row;
+}
+
+// Енергія обчислення на мільйон клітинок; 0, якщо драйвер її не виміряв
+static double j_per_mcell(const scaling_row *r) {
+    return r->result.joules / ((double) r->width * r->height / 1e6);
+}
+
+static void write_csv(FILE *out) {
+    fprintf(out, "mode,backend,workers,width,height,seconds,wall,speedup,efficiency,karp_flatt,match%s\n",
+            energy ? ",joules,j_per_mcell" : "");
+    for (int k = 0; k < n_rows; k++) {
+        const scaling_row *r = &rows[k];
+        fprintf(out, "%s,%s,%d,%d,%d,%.6f,%.6f,%.4f,%.4f,%.4f,%d",
+                r->mode, r->backend, r->workers, r->width, r->height, r->seconds, r->wall,
+                r->speedup, r->efficiency, r->karp_flatt, r->match);
+        if (energy) fprintf(out, ",%.3f,%.6f", r->result.joules, j_per_mcell(r));
+        fprintf(out, "\n");
+    }
+}
+
+static void write_json(FILE *out) {
+    fprintf(out, "[\n");
+    for (int k = 0; k < n_rows; k++) {
+        const scaling_row *r = &rows[k];
+        char hex[FINGERPRINT_HEX_LEN];
+        fingerprint_format(r->result.fingerprint, hex);
+        fprintf(out, "  {\"mode\": \"%s\", \"backend\": \"%s\", \"workers\": %d, "
+                     "\"width\": %d, \"height\": %d, \"seconds\": %.6f, \"wall\": %.6f, "
+                     "\"speedup\": %.4f, \"efficiency\": %.4f, \"karp_flatt\": %.4f, "
+                     "\"match\": %s, \"min\": %llu, \"max\": %llu, \"fingerprint\": \"%s\"",
+                r->mode, r->backend, r->workers, r->width, r->height, r->seconds, r->wall,
+                r->speedup, r->efficiency, r->karp_flatt, r->match ? "true" : "false",
+                r->result.min, r->result.max, hex);
+        if (energy) fprintf(out, ", \"joules\": %.3f, \"j_per_mcell\": %.6f", r->result.joules, j_per_mcell(r));
+        fprintf(out, "}%s\n", k + 1 < n_rows ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Використання: %s [параметри]\n"
+            "  --bin=DIR             каталог з seq, openmp, pthreads та mpi (за замовчуванням .)\n"
+            "  --backends=LIST       seq,openmp,mpi,pthreads\n"
+            "  --threads=LIST        кількості потоків OpenMP та pthreads, напр. 1,2,4,8\n"
+            "  --ranks=LIST          кількості процесів MPI\n"
+            "  --sizes=LIST          розміри сітки, напр. 1000x1000,3000x3000\n"
+            "  --mode=strong|weak|both\n"
+            "  --reps=N              повторів на вимір, звіт — медіана\n"
+            "  --mpirun=CMD          префікс запуску MPI, до нього додається кількість процесів\n"
+            "  --formula=row|diag    спільна формула повідомлень (за замовчуванням diag)\n"
+            "  --e=N                 спільна експонента (за замовчуванням e_const openmp/mpi)\n"
+            "  --driver-args=ARGS    додаткові параметри драйверів, напр. --kernel=mont\n"
+            "  --energy              енергія RAPL драйверів: колонки joules та j_per_mcell\n"
+            "  --format=csv|json     формат звіту\n"
+            "  --out=FILE            файл звіту замість stdout\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *backends = "seq,openmp,pthreads,mpi";
+    const char *mode = "strong";
+    const char *format = "csv";
+    const char *out_path = NULL;
+    int threads[MAX_LIST] = {1, 2, 4}, n_threads = 3;
+    int ranks[MAX_LIST] = {1, 2, 4}, n_ranks = 3;
+    grid_size sizes[MAX_LIST] = {{1000, 1000}};
+    int n_sizes = 1;
+
+    for (int a = 1; a < argc; a++) {
+        const char *arg = argv[a];
+        if (strncmp(arg, "--bin=", 6) == 0) bin_dir = arg + 6;
+        else if (strncmp(arg, "--backends=", 11) == 0) backends = arg + 11;
+        else if (strncmp(arg, "--threads=", 10) == 0) n_threads = parse_int_list(arg + 10, threads);
+        else if (strncmp(arg, "--ranks=", 8) == 0) n_ranks = parse_int_list(arg + 8, ranks);
+        else if (strncmp(arg, "--sizes=", 8) == 0) n_sizes = parse_sizes(arg + 8, sizes);
+        else if (strncmp(arg, "--mode=", 7) == 0) mode = arg + 7;
+        else if (strncmp(arg, "--reps=", 7) == 0) reps = atoi(arg + 7);
+        else if (strncmp(arg, "--mpirun=", 9) == 0) mpirun = arg + 9;
+        else if (strncmp(arg, "--formula=", 10) == 0) formula = arg + 10;
+        else if (strncmp(arg, "--e=", 4) == 0) exponent = arg + 4;
+        else if (strncmp(arg, "--driver-args=", 14) == 0) driver_args = arg + 14;
+        else if (strcmp(arg, "--energy") == 0) energy = 1;
+        else if (strncmp(arg, "--format=", 9) == 0) format = arg + 9;
+        else if (strncmp(arg, "--out=", 6) == 0) out_path = arg + 6;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (reps < 1 || n_sizes < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int strong = strcmp(mode, "strong") == 0 || strcmp(mode, "both") == 0;
+    int weak = strcmp(mode, "weak") == 0 || strcmp(mode, "both") == 0;
+
+    for (int s = 0; s < n_sizes; s++) {
+        // Базовий час завжди з seq, навіть якщо його немає у --backends
+        scaling_row *base = measure("base", "seq", 1, sizes[s], 0.0);
+        if (!base) return 1;
+        double t1 = base->seconds;
+        base->speedup = base->efficiency = 1.0;
+
+        for (int k = 0; strong && k < n_threads; k++)
+            if (has_backend(backends, "openmp")) measure("strong", "openmp", threads[k], sizes[s], t1);
+        for (int k = 0; strong && k < n_threads; k++)
+            if (has_backend(backends, "pthreads")) measure("strong", "pthreads", threads[k], sizes[s], t1);
+        for (int k = 0; strong && k < n_ranks; k++)
+            if (has_backend(backends, "mpi")) measure("strong", "mpi", ranks[k], sizes[s], t1);
+
+        for (int k = 0; weak && k < n_threads; k++) {
+            grid_size scaled = {sizes[s].width, sizes[s].height * threads[k]};
+            if (has_backend(backends, "openmp")) measure("weak", "openmp", threads[k], scaled, t1);
+            if (has_backend(backends, "pthreads")) measure("weak", "pthreads", threads[k], scaled, t1);
+        }
+        for (int k = 0; weak && k < n_ranks; k++) {
+            grid_size scaled = {sizes[s].width, sizes[s].height * ranks[k]};
+            if (has_backend(backends, "mpi")) measure("weak", "mpi", ranks[k], scaled, t1);
+        }
+    }
+
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        perror(out_path);
+        return 1;
+    }
+    if (strcmp(format, "json") == 0) write_json(out);
+    else write_csv(out);
+    if (out != stdout) fclose(out);
+
+    for (int k = 0; k < n_rows; k++)
+        if (!rows[k].match) return 2;
+    return 0;
+}
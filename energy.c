@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "energy.h"
+
+// Шлях до зони: intel-rapl:N (зона) або intel-rapl:N:M (підзона)
+#define ZONE_PREFIX "intel-rapl:"
+#define ZONE_PATH_LEN 512
+
+static int cmp_name(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+// Перший рядок файлу без переводу рядка; 0 або -1
+static int read_line(const char *root, const char *zone, const char *file, char *out, size_t len) {
+    char path[ZONE_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s/%s", root, zone, file);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int ok = fgets(out, (int) len, f) != NULL;
+    fclose(f);
+    if (!ok) return -1;
+    out[strcspn(out, "\n")] = '\0';
+    return 0;
+}
+
+static int read_counter(int fd, ull *value) {
+    char buf[32];
+    ssize_t got = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (got <= 0) return -1;
+    buf[got] = '\0';
+    *value = strtoull(buf, NULL, 10);
+    return 0;
+}
+
+static int add_zone(energy_meter *m, const char *root, const char *zone) {
+    char name[ENERGY_NAME_LEN / 2], range[32], path[ZONE_PATH_LEN];
+    if (read_line(root, zone, "name", name, sizeof(name)) != 0 ||
+        read_line(root, zone, "max_energy_range_uj", range, sizeof(range)) != 0)
+        return -1;
+    snprintf(path, sizeof(path), "%s/%s/energy_uj", root, zone);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    ull first;
+    if (fd < 0) return -1;
+    if (read_counter(fd, &first) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    int k = m->count++;
+    m->fd[k] = fd;
+    m->range[k] = strtoull(range, NULL, 10);
+    m->last[k] = first;
+    m->joules[k] = 0.0;
+    // Підзона називається через батьківську зону: package-0/dram
+    const char *sub = strchr(zone + strlen(ZONE_PREFIX), ':');
+    if (sub) {
+        char parent[64], parent_name[ENERGY_NAME_LEN / 2];
+        snprintf(parent, sizeof(parent), "%.*s", (int) (sub - zone), zone);
+        if (read_line(root, parent, "name", parent_name, sizeof(parent_name)) != 0)
+            strcpy(parent_name, parent);
+        snprintf(m->name[k], ENERGY_NAME_LEN, "%s/%s", parent_name, name);
+        m->summed[k] = strcmp(name, "dram") == 0;
+    } else {
+        snprintf(m->name[k], ENERGY_NAME_LEN, "%s", name);
+        m->summed[k] = strncmp(name, "package", 7) == 0;
+    }
+    return 0;
+}
+
+static void update_locked(energy_meter *m) {
+    for (int k = 0; k < m->count; k++) {
+        ull now;
+        if (read_counter(m->fd[k], &now) != 0) continue;
+        // Лічильник після range починає з нуля
+        ull delta = now >= m->last[k] ? now - m->last[k] : m->range[k] - m->last[k] + now;
+        m->joules[k] += delta * 1e-6;
+        m->last[k] = now;
+    }
+}
+
+static void *poll_loop(void *arg) {
+    energy_meter *m = arg;
+    pthread_mutex_lock(&m->lock);
+    while (!m->stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += ENERGY_POLL_SECONDS;
+        pthread_cond_timedwait(&m->wake, &m->lock, &deadline);
+        if (!m->stop) update_locked(m);
+    }
+    pthread_mutex_unlock(&m->lock);
+    return NULL;
+}
+
+int energy_open(energy_meter *m, const char *root) {
+    memset(m, 0, sizeof(*m));
+    DIR *dir = opendir(root);
+    if (!dir) return -1;
+    char *zones[ENERGY_MAX_DOMAINS];
+    int nzones = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) && nzones < ENERGY_MAX_DOMAINS)
+        if (strncmp(ent->d_name, ZONE_PREFIX, strlen(ZONE_PREFIX)) == 0)
+            zones[nzones++] = strdup(ent->d_name);
+    closedir(dir);
+    // Порядок readdir не визначений, а звіт має бути стабільним
+    qsort(zones, nzones, sizeof(char *), cmp_name);
+    for (int z = 0; z < nzones; z++) {
+        if (zones[z]) add_zone(m, root, zones[z]);
+        free(zones[z]);
+    }
+    if (m->count == 0) return -1;
+
+    // Без пакетів (лише psys) сумуються зони верхнього рівня
+    int any = 0;
+    for (int k = 0; k < m->count; k++) any |= m->summed[k];
+    if (!any)
+        for (int k = 0; k < m->count; k++) m->summed[k] = strchr(m->name[k], '/') == NULL;
+
+    pthread_mutex_init(&m->lock, NULL);
+    pthread_cond_init(&m->wake, NULL);
+    m->polling = pthread_create(&m->poller, NULL, poll_loop, m) == 0;
+    return 0;
+}
+
+double energy_read(energy_meter *m) {
+    double total = 0.0;
+    pthread_mutex_lock(&m->lock);
+    update_locked(m);
+    for (int k = 0; k < m->count; k++)
+        if (m->summed[k]) total += m->joules[k];
+    pthread_mutex_unlock(&m->lock);
+    return total;
+}
+
+void energy_report(energy_meter *m) {
+    energy_read(m);
+    for (int k = 0; k < m->count; k++)
+        printf("  %-24s %12.3f Дж%s\n", m->name[k], m->joules[k], m->summed[k] ? "" : "  (не в сумі)");
+}
+
+void energy_close(energy_meter *m) {
+    if (m->count == 0) return;
+    if (m->polling) {
+        pthread_mutex_lock(&m->lock);
+        m->stop = 1;
+        pthread_cond_signal(&m->wake);
+        pthread_mutex_unlock(&m->lock);
+        pthread_join(m->poller, NULL);
+    }
+    for (int k = 0; k < m->count; k++) close(m->fd[k]);
+    pthread_mutex_destroy(&m->lock);
+    pthread_cond_destroy(&m->wake);
+    m->count = 0;
+}
@@ -0,0 +1,50 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <pthread.h>
+#include "kernels.h"
+
+// Енергія з лічильників RAPL через /sys/class/powercap (--energy). Кожна
+// зона intel-rapl:N (пакет або psys) та її підзони (core, uncore, dram)
+// мають монотонний лічильник energy_uj, який після max_energy_range_uj
+// починає з нуля. Приріст між читаннями враховує одне переповнення, а
+// фоновий потік читає лічильники кожні ENERGY_POLL_SECONDS, тож фаза,
+// довша за повне коло лічильника, теж рахується правильно.
+//
+// Сума — пакети плюс dram: core та uncore входять у пакет, psys охоплює
+// всю платформу, тож вони лише показуються окремо.
+
+#define ENERGY_SYSFS "/sys/class/powercap"
+#define ENERGY_MAX_DOMAINS 32
+#define ENERGY_NAME_LEN 48
+#define ENERGY_POLL_SECONDS 5
+
+#define ENERGY_UNAVAILABLE_MSG \
+    "RAPL недоступний (немає " ENERGY_SYSFS "/intel-rapl:* або energy_uj читає лише root), енергію не виміряно\n"
+
+typedef struct {
+    int count;
+    int fd[ENERGY_MAX_DOMAINS];
+    char name[ENERGY_MAX_DOMAINS][ENERGY_NAME_LEN];     // "package-0", "package-0/dram"
+    int summed[ENERGY_MAX_DOMAINS];                     // входить у загальну суму
+    ull range[ENERGY_MAX_DOMAINS], last[ENERGY_MAX_DOMAINS];
+    double joules[ENERGY_MAX_DOMAINS];                  // з energy_open
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t poller;
+    int polling, stop;
+} energy_meter;
+
+// root — зазвичай ENERGY_SYSFS. Повертає 0 або -1, якщо жодна зона не читається.
+int energy_open(energy_meter *m, const char *root);
+
+// Джоулі сумованих доменів з energy_open
+double energy_read(energy_meter *m);
+
+// Джоулі кожного домену з energy_open
+void energy_report(energy_meter *m);
+
+void energy_close(energy_meter *m);
+
+#endif
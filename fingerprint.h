@@ -0,0 +1,63 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include "kernels.h"
+
+// 128-бітний відбиток сітки: сума за модулем 2^64 (у двох незалежних ланах)
+// хешів кожної клітинки разом з її позицією i * width + j. Сума не залежить
+// від порядку, тож потоки й процеси рахують свої рядки окремо, а об'єднання —
+// звичайне додавання (reduction(+) в OpenMP, MPI_SUM в MPI) без збору сітки.
+typedef struct {
+    ull a, b;
+} grid_fingerprint;
+
+// Фіналізатор MurmurHash3: кожен біт входу впливає на всі біти виходу
+static inline ull fmix64(ull k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// Внесок рядка з першою клітинкою за індексом first_index; рахувати одразу
+// після шифрування рядка, поки він у кеші
+static inline grid_fingerprint fingerprint_row(ull first_index, const ull *row, int width) {
+    grid_fingerprint fp = {0, 0};
+    for (int j = 0; j < width; j++) {
+        // Лани ключуються окремо: інший множник позиції й повернуте значення,
+        // тож збіг сум в одній лані не тягне збігу в іншій
+        ull index = first_index + j;
+        ull x = row[j] ^ (index * 0x9E3779B97F4A7C15ULL);
+        ull y = ((row[j] << 32) | (row[j] >> 32)) ^ (index * 0xC2B2AE3D27D4EB4FULL);
+        fp.a += fmix64(x);
+        fp.b += fmix64(y ^ 0x2545F4914F6CDD1DULL);
+    }
+    return fp;
+}
+
+static inline void fingerprint_add(grid_fingerprint *sum, grid_fingerprint part) {
+    sum->a += part.a;
+    sum->b += part.b;
+}
+
+// Прив'язує суму до розміру сітки
+static inline grid_fingerprint fingerprint_finish(grid_fingerprint sum, int width, int height) {
+    ull dims = ((ull) width << 32) | (ull) height;
+    grid_fingerprint fp = {fmix64(sum.a ^ fmix64(dims)), fmix64(sum.b + dims)};
+    return fp;
+}
+
+static inline int fingerprint_equal(grid_fingerprint x, grid_fingerprint y) {
+    return x.a == y.a && x.b == y.b;
+}
+
+// 32 шістнадцяткові цифри; буфер — щонайменше FINGERPRINT_HEX_LEN
+#define FINGERPRINT_HEX_LEN 33
+void fingerprint_format(grid_fingerprint fp, char *out);
+
+// Повертає 0 або -1, якщо рядок не є 32 шістнадцятковими цифрами
+int fingerprint_parse(const char *hex, grid_fingerprint *fp);
+
+#endif
@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "options.h"
+#include "report.h"
+#include "timing.h"
+#include "gridd_proto.h"
+
+// Клієнт демона gridd: шле запит, відображає memfd з клітинками й друкує
+// те саме, що драйвери. З --repeat=N вимірює затримку запитів.
+//
+//   gridctl [--socket=PATH] [--op=grid|region|stats|shutdown] [--region=R,C,RxC]
+//           [--repeat=N] [--no-cache] [параметри сітки драйверів: --size, --e, --kernel, ...]
+
+#define WIDTH 3000
+#define HEIGHT 3000
+#define MAX_ARGS 64
+
+// Експонента демона за замовчуванням, як e_const драйверів
+const ll e_const = 900000000000000LL;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static int connect_daemon(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock >= 0 && connect(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static const char *status_name(uint32_t status) {
+    switch (status) {
+        case GRIDD_OK: return "ok";
+        case GRIDD_EBADREQ: return "некоректний запит";
+        case GRIDD_ENOMEM: return "не вистачило пам'яті";
+        default: return "внутрішня помилка";
+    }
+}
+
+// Один запит; клітинки лишаються відображеними в *cells (або NULL)
+static int request(int sock, const gridd_request *req, gridd_response *resp, const ull **cells) {
+    int fd;
+    *cells = NULL;
+    if (gridd_send(sock, req, sizeof(*req), -1) != 0 || gridd_recv(sock, resp, sizeof(*resp), &fd) != 0) {
+        fprintf(stderr, "Демон розірвав з'єднання\n");
+        return -1;
+    }
+    if (resp->magic != GRIDD_MAGIC || resp->status != GRIDD_OK) {
+        fprintf(stderr, "Демон відхилив запит: %s\n", status_name(resp->status));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if (fd >= 0) {
+        void *map = resp->bytes ? mmap(NULL, resp->bytes, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (map == MAP_FAILED) {
+            fprintf(stderr, "Не вдалося відобразити результат\n");
+            return -1;
+        }
+        *cells = map;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = GRIDD_SOCKET_DEFAULT;
+    gridd_op op = GRIDD_OP_GRID;
+    int region[4] = {0, 0, 0, 0};
+    int repeat = 1;
+    uint32_t flags = 0;
+
+    // Власні параметри клієнта, решта — до parse_options
+    char *rest[MAX_ARGS];
+    int rest_count = 0;
+    rest[rest_count++] = argv[0];
+    for (int a = 1; a < argc; a++) {
+        const char *arg = argv[a];
+        if (strncmp(arg, "--socket=", 9) == 0) {
+            path = arg + 9;
+        } else if (strncmp(arg, "--op=", 5) == 0) {
+            const char *name = arg + 5;
+            if (strcmp(name, "grid") == 0) op = GRIDD_OP_GRID;
+            else if (strcmp(name, "region") == 0) op = GRIDD_OP_REGION;
+            else if (strcmp(name, "stats") == 0) op = GRIDD_OP_STATS;
+            else if (strcmp(name, "shutdown") == 0) op = GRIDD_OP_SHUTDOWN;
+            else {
+                fprintf(stderr, "Невідома операція: %s\n", name);
+                return 1;
+            }
+        } else if (strncmp(arg, "--region=", 9) == 0) {
+            if (sscanf(arg + 9, "%d,%d,%dx%d", &region[0], &region[1], &region[2], &region[3]) != 4) {
+                fprintf(stderr, "Некоректний прямокутник: %s\n", arg);
+                return 1;
+            }
+            op = GRIDD_OP_REGION;
+        } else if (strncmp(arg, "--repeat=", 9) == 0) {
+            repeat = atoi(arg + 9);
+        } else if (strcmp(arg, "--no-cache") == 0) {
+            flags |= GRIDD_NO_CACHE;
+        } else if (rest_count < MAX_ARGS) {
+            rest[rest_count++] = argv[a];
+        }
+    }
+
+    grid_options opts;
+    if (parse_options(rest_count, rest, &opts) != 0) return 1;
+    if (opts.verify || opts.exponent_count || opts.output || opts.extend || repeat < 1) {
+        fprintf(stderr, "gridctl не підтримує --verify, --exponents, --output та --extend; "
+                "--repeat має бути додатним\n");
+        return 1;
+    }
+    int width = opts.width ? opts.width : WIDTH;
+    int height = opts.height ? opts.height : HEIGHT;
+
+    gridd_request req;
+    memset(&req, 0, sizeof(req));
+    req.magic = GRIDD_MAGIC;
+    req.version = GRIDD_VERSION;
+    req.op = (uint16_t) op;
+    req.e = opts.e;
+    req.col_step = grid_col_step(&opts, FORMULA_DIAG, width);
+    req.width = (uint32_t) width;
+    req.height = (uint32_t) height;
+    req.kernel = (uint32_t) opts.kernel;
+    req.ilp = (uint32_t) opts.ilp;
+    req.row = (uint32_t) region[0];
+    req.col = (uint32_t) region[1];
+    req.rows = (uint32_t) region[2];
+    req.cols = (uint32_t) region[3];
+    req.flags = flags;
+
+    int sock = connect_daemon(path);
+    if (sock < 0) {
+        fprintf(stderr, "Не вдалося з'єднатися з демоном %s\n", path);
+        return 1;
+    }
+
+    gridd_response resp;
+    const ull *cells = NULL;
+    if (op == GRIDD_OP_SHUTDOWN) {
+        int rc = request(sock, &req, &resp, &cells);
+        close(sock);
+        return rc == 0 ? 0 : 1;
+    }
+
+    // Затримка — від запиту до відображених клітинок, разом з обчисленням у демоні
+    double *latency = malloc(repeat * sizeof(double));
+    double *compute = malloc(repeat * sizeof(double));
+    int cached = 0;
+    for (int r = 0; r < repeat; r++) {
+        if (cells) munmap((void *) cells, resp.bytes);
+        double t0 = wall_now();
+        if (request(sock, &req, &resp, &cells) != 0) {
+            close(sock);
+            return 1;
+        }
+        latency[r] = wall_now() - t0;
+        compute[r] = resp.seconds;
+        cached += resp.cached;
+    }
+    close(sock);
+
+    int rows = (int) resp.rows, cols = (int) resp.cols;
+    grid_kernel kernel = opts.kernel == KERNEL_AUTO ? KERNEL_LEGACY : opts.kernel;
+    grid_summary summary = {"gridd", (int) resp.workers, cols, rows, grid_kernel_name(kernel), opts.ilp,
+                            opts.e ? opts.e : (ull) e_const, req.col_step,
+                            resp.seconds, resp.min, resp.max, {0}};
+    for (int k = 0; k < GRID_PROBES; k++) summary.probes[k] = resp.probes[k];
+    // Контрольні клітинки читаються прямо зі спільної пам'яті
+    if (cells) grid_probes(cells, cols, rows, summary.probes);
+
+    printf("Згенеровано зображення %dx%d за %f секунд. min = %llu, max = %llu\n",
+           cols, rows, resp.seconds, (ull) resp.min, (ull) resp.max);
+    printf("Верхній лівий: %llu\n", summary.probes[0]);
+    printf("Верхній правий: %llu\n", summary.probes[1]);
+    printf("Нижній лівий: %llu\n", summary.probes[2]);
+    printf("Нижній правий: %llu\n", summary.probes[3]);
+    printf("Центр: %llu\n", summary.probes[4]);
+
+    int rc = 0;
+    if (opts.checksum) {
+        summary.has_fingerprint = 1;
+        summary.fingerprint = (grid_fingerprint) {resp.fingerprint_a, resp.fingerprint_b};
+        if (report_fingerprint(&summary.fingerprint, opts.golden) != 0) rc = 3;
+    }
+    if (opts.summary) print_summary(&summary);
+
+    if (repeat > 1) {
+        qsort(latency, repeat, sizeof(double), cmp_double);
+        qsort(compute, repeat, sizeof(double), cmp_double);
+        printf("Запитів %d, з кешу %d. Затримка, мс: p50 %.3f, p99 %.3f, max %.3f; "
+               "обчислення в демоні p50 %.3f\n",
+               repeat, cached, latency[repeat / 2] * 1e3, latency[(int) (0.99 * (repeat - 1))] * 1e3,
+               latency[repeat - 1] * 1e3, compute[repeat / 2] * 1e3);
+    }
+    if (cells) munmap((void *) cells, resp.bytes);
+    free(latency);
+    free(compute);
+    return rc;
+}
@@ -0,0 +1,357 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "rsagrid.h"
+#include "gridd_proto.h"
+#include "timing.h"
+
+// Демон сітки: тримає теплий пул потоків, підготовлені контексти ключів
+// (константи Монтгомері/Барретта) і кеш останніх результатів, відповідає на
+// запити по Unix-сокету (протокол — gridd_proto.h). Запити обробляються по
+// одному: обчислення й так займає весь пул.
+//
+//   gridd [--socket=PATH] [--threads=N] [--tile-rows=N] [--contexts=N]
+//         [--cache=N] [--cache-mb=N]
+
+#define MAX_CLIENTS 64
+#define MAX_CONTEXTS 64
+#define MAX_CACHE 1024
+// Клієнт, що надіслав лише частину запиту (або не читає відповідь), не має
+// тримати однопотоковий цикл довше за цей час — з'єднання закривається
+#define CLIENT_TIMEOUT_SEC 2
+
+// Підготовлений контекст для ключа, ядра та розмірів сітки
+typedef struct {
+    ull n, e, col_step;
+    int width, height;
+    grid_kernel kernel;
+    int ilp;
+    rsagrid *grid;
+    unsigned long last_use;
+} grid_context;
+
+// Готова відповідь разом із запечатаним memfd (-1 для STATS)
+typedef struct {
+    gridd_request key;
+    gridd_response response;
+    int fd;
+    unsigned long last_use;
+} cached_result;
+
+static workpool *pool;
+static int tile_rows = 0;
+static int max_contexts = 8, max_cache = 16;
+static size_t cache_limit = (size_t) 512 << 20;
+
+static grid_context contexts[MAX_CONTEXTS];
+static int context_count;
+static cached_result cache[MAX_CACHE];
+static int cache_count;
+static size_t cache_bytes;
+static unsigned long use_clock;
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig) {
+    (void) sig;
+    stop = 1;
+}
+
+static grid_context *find_context(const gridd_request *req) {
+    rsagrid_config cfg;
+    rsagrid_config_default(&cfg);
+    if (req->n) cfg.n = req->n;
+    if (req->e) cfg.e = req->e;
+    cfg.width = (int) req->width;
+    cfg.height = (int) req->height;
+    cfg.col_step = req->col_step ? req->col_step : (ull) req->width;
+    cfg.kernel = (grid_kernel) req->kernel;
+    cfg.ilp = req->ilp ? (int) req->ilp : 1;
+    cfg.pool = pool;
+    cfg.tile_rows = tile_rows;
+
+    for (int k = 0; k < context_count; k++) {
+        grid_context *c = &contexts[k];
+        if (c->n == cfg.n && c->e == cfg.e && c->col_step == cfg.col_step && c->width == cfg.width &&
+            c->height == cfg.height && c->kernel == cfg.kernel && c->ilp == cfg.ilp) {
+            c->last_use = ++use_clock;
+            return c;
+        }
+    }
+
+    rsagrid *grid = rsagrid_create(&cfg);
+    if (!grid) return NULL;
+    grid_context *slot = &contexts[context_count];
+    if (context_count == max_contexts) {
+        // Витісняємо найдавніше використаний
+        slot = &contexts[0];
+        for (int k = 1; k < context_count; k++)
+            if (contexts[k].last_use < slot->last_use) slot = &contexts[k];
+        rsagrid_destroy(slot->grid);
+    } else {
+        context_count++;
+    }
+    *slot = (grid_context) {cfg.n, cfg.e, cfg.col_step, cfg.width, cfg.height, cfg.kernel, cfg.ilp,
+                             grid, ++use_clock};
+    return slot;
+}
+
+static int same_request(const gridd_request *a, const gridd_request *b) {
+    return a->op == b->op && a->n == b->n && a->e == b->e && a->col_step == b->col_step &&
+           a->width == b->width && a->height == b->height && a->kernel == b->kernel && a->ilp == b->ilp &&
+           a->row == b->row && a->col == b->col && a->rows == b->rows && a->cols == b->cols;
+}
+
+static cached_result *cache_find(const gridd_request *req) {
+    for (int k = 0; k < cache_count; k++)
+        if (same_request(&cache[k].key, req)) return &cache[k];
+    return NULL;
+}
+
+static void cache_drop(int k) {
+    if (cache[k].fd >= 0) close(cache[k].fd);
+    cache_bytes -= cache[k].response.bytes;
+    cache[k] = cache[--cache_count];
+}
+
+// Кешує відповідь; fd переходить у власність кешу
+static void cache_put(const gridd_request *req, const gridd_response *resp, int fd) {
+    cached_result *old = cache_find(req);
+    if (old) cache_drop((int) (old - cache));
+    while (cache_count > 0 && (cache_count >= max_cache || cache_bytes + resp->bytes > cache_limit)) {
+        int oldest = 0;
+        for (int k = 1; k < cache_count; k++)
+            if (cache[k].last_use < cache[oldest].last_use) oldest = k;
+        cache_drop(oldest);
+    }
+    if (max_cache == 0 || resp->bytes > cache_limit) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+    cache[cache_count++] = (cached_result) {*req, *resp, fd, ++use_clock};
+    cache_bytes += resp->bytes;
+}
+
+// Обчислює запит; для GRID і REGION клітинки пишуться прямо у memfd.
+// Повертає дескриптор (або -1 для STATS) через *fd.
+static gridd_status compute(const gridd_request *req, gridd_response *resp, int *fd) {
+    *fd = -1;
+    if (req->width < 1 || req->height < 1 || req->width > (1u << 30) || req->height > (1u << 30) ||
+        req->kernel > KERNEL_MONT || req->ilp > ILP_MAX)
+        return GRIDD_EBADREQ;
+    int row = 0, col = 0, rows = (int) req->height, cols = (int) req->width;
+    if (req->op == GRIDD_OP_REGION) {
+        row = (int) req->row;
+        col = (int) req->col;
+        rows = (int) req->rows;
+        cols = (int) req->cols;
+        if (req->row >= req->height || req->col >= req->width || rows < 1 || cols < 1 ||
+            req->rows > req->height - req->row || req->cols > req->width - req->col)
+            return GRIDD_EBADREQ;
+    }
+
+    grid_context *ctx = find_context(req);
+    if (!ctx) return GRIDD_EBADREQ;
+
+    size_t bytes = 0;
+    ull *cells = NULL;
+    if (req->op != GRIDD_OP_STATS) {
+        bytes = (size_t) rows * cols * sizeof(ull);
+        *fd = memfd_create("rsagrid", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (*fd < 0 || ftruncate(*fd, (off_t) bytes) != 0) {
+            if (*fd >= 0) close(*fd);
+            *fd = -1;
+            return GRIDD_ENOMEM;
+        }
+        cells = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+        if (cells == MAP_FAILED) {
+            close(*fd);
+            *fd = -1;
+            return GRIDD_ENOMEM;
+        }
+    }
+
+    rsagrid_result result;
+    rsagrid_set_output(ctx->grid, cells, (size_t) cols);
+    int rc = rsagrid_compute_region(ctx->grid, row, col, rows, cols, &result);
+    rsagrid_set_output(ctx->grid, NULL, 0);
+    if (cells) {
+        munmap(cells, bytes);
+        // Після печатки файл незмінний, тож його безпечно роздавати з кешу
+        if (rc == 0 && fcntl(*fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0)
+            rc = -1;
+        if (rc != 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    if (rc != 0) return GRIDD_EINTERNAL;
+
+    resp->has_fd = *fd >= 0;
+    resp->workers = (uint32_t) rsagrid_workers(ctx->grid);
+    resp->rows = (uint32_t) rows;
+    resp->cols = (uint32_t) cols;
+    resp->bytes = bytes;
+    resp->min = result.min;
+    resp->max = result.max;
+    for (int k = 0; k < GRIDD_PROBES; k++) resp->probes[k] = result.probes[k];
+    resp->fingerprint_a = result.fingerprint.a;
+    resp->fingerprint_b = result.fingerprint.b;
+    resp->seconds = result.seconds;
+    return GRIDD_OK;
+}
+
+// Обробляє один запит клієнта; повертає -1, якщо з'єднання треба закрити
+static int serve(int sock) {
+    gridd_request req;
+    int stray;
+    if (gridd_recv(sock, &req, sizeof(req), &stray) != 0) return -1;
+    if (stray >= 0) close(stray);
+
+    gridd_response resp;
+    memset(&resp, 0, sizeof(resp));
+    resp.magic = GRIDD_MAGIC;
+    if (req.magic != GRIDD_MAGIC || req.version != GRIDD_VERSION) {
+        resp.status = GRIDD_EBADREQ;
+        gridd_send(sock, &resp, sizeof(resp), -1);
+        return -1;
+    }
+    if (req.op == GRIDD_OP_SHUTDOWN) {
+        stop = 1;
+        return gridd_send(sock, &resp, sizeof(resp), -1);
+    }
+    if (req.op < GRIDD_OP_GRID || req.op > GRIDD_OP_STATS) {
+        resp.status = GRIDD_EBADREQ;
+        return gridd_send(sock, &resp, sizeof(resp), -1);
+    }
+    if (req.op != GRIDD_OP_REGION) req.row = req.col = req.rows = req.cols = 0;
+
+    cached_result *hit = (req.flags & GRIDD_NO_CACHE) ? NULL : cache_find(&req);
+    if (hit) {
+        hit->last_use = ++use_clock;
+        resp = hit->response;
+        resp.cached = 1;
+        resp.seconds = 0.0;
+        return gridd_send(sock, &resp, sizeof(resp), hit->fd);
+    }
+
+    int fd;
+    resp.status = compute(&req, &resp, &fd);
+    int rc = gridd_send(sock, &resp, sizeof(resp), fd);
+    if (resp.status == GRIDD_OK) cache_put(&req, &resp, fd);
+    return rc;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Використання: %s [параметри]\n"
+            "  --socket=PATH     Unix-сокет (за замовчуванням " GRIDD_SOCKET_DEFAULT ")\n"
+            "  --threads=N       виконавців пулу, за замовчуванням — CPU\n"
+            "  --tile-rows=N     рядків у задачі пулу\n"
+            "  --contexts=N      підготовлених контекстів ключ/розмір (за замовчуванням 8)\n"
+            "  --cache=N         результатів у кеші (за замовчуванням 16, 0 — без кешу)\n"
+            "  --cache-mb=N      межа пам'яті кешу в МБ (за замовчуванням 512)\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = GRIDD_SOCKET_DEFAULT;
+    int threads = 0;
+    for (int a = 1; a < argc; a++) {
+        if (strncmp(argv[a], "--socket=", 9) == 0) path = argv[a] + 9;
+        else if (strncmp(argv[a], "--threads=", 10) == 0) threads = atoi(argv[a] + 10);
+        else if (strncmp(argv[a], "--tile-rows=", 12) == 0) tile_rows = atoi(argv[a] + 12);
+        else if (strncmp(argv[a], "--contexts=", 11) == 0) max_contexts = atoi(argv[a] + 11);
+        else if (strncmp(argv[a], "--cache=", 8) == 0) max_cache = atoi(argv[a] + 8);
+        else if (strncmp(argv[a], "--cache-mb=", 11) == 0) cache_limit = (size_t) atoll(argv[a] + 11) << 20;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 0 || tile_rows < 0 || max_contexts < 1 || max_contexts > MAX_CONTEXTS ||
+        max_cache < 0 || max_cache > MAX_CACHE) {
+        fprintf(stderr, "Некоректні параметри демона\n");
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Задовгий шлях сокета: %s\n", path);
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+
+    if (threads == 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    pool = workpool_create(threads > 0 ? threads : 1);
+    if (!pool) {
+        fprintf(stderr, "Помилка створення пулу потоків!\n");
+        return 1;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct stat st;
+    // Сокет від попереднього запуску, який не прибрав за собою
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+    if (listener < 0 || bind(listener, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+        listen(listener, MAX_CLIENTS) != 0) {
+        fprintf(stderr, "Не вдалося слухати %s: %s\n", path, strerror(errno));
+        workpool_destroy(pool);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    fprintf(stderr, "gridd: слухаю %s, виконавців %d\n", path, workpool_size(pool));
+
+    struct pollfd fds[MAX_CLIENTS + 1];
+    int nfds = 1;
+    fds[0] = (struct pollfd) {listener, POLLIN, 0};
+    while (!stop) {
+        if (poll(fds, (nfds_t) nfds, -1) < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "poll: %s\n", strerror(errno));
+            break;
+        }
+        for (int k = nfds - 1; k >= 1; k--) {
+            if (!fds[k].revents) continue;
+            if ((fds[k].revents & POLLIN) && serve(fds[k].fd) == 0) continue;
+            close(fds[k].fd);
+            fds[k] = fds[--nfds];
+        }
+        if (fds[0].revents & POLLIN) {
+            int client = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+            struct timeval timeout = {CLIENT_TIMEOUT_SEC, 0};
+            if (client >= 0 && nfds <= MAX_CLIENTS &&
+                setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0 &&
+                setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0)
+                fds[nfds++] = (struct pollfd) {client, POLLIN, 0};
+            else if (client >= 0) close(client);
+        }
+    }
+
+    for (int k = 1; k < nfds; k++) close(fds[k].fd);
+    close(listener);
+    unlink(path);
+    while (cache_count > 0) cache_drop(cache_count - 1);
+    for (int k = 0; k < context_count; k++) rsagrid_destroy(contexts[k].grid);
+    workpool_destroy(pool);
+    fprintf(stderr, "gridd: зупинено\n");
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "gridd_proto.h"
+
+int gridd_send(int sock, const void *msg, size_t size, int fd) {
+    struct iovec iov = {(void *) msg, size};
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    if (fd >= 0) {
+        memset(&control, 0, sizeof(control));
+        mh.msg_control = control.buf;
+        mh.msg_controllen = sizeof(control.buf);
+        struct cmsghdr *c = CMSG_FIRSTHDR(&mh);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &fd, sizeof(int));
+    }
+
+    // Дескриптор іде з першим шматком, решта — звичайним write
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t k = sent == 0 ? sendmsg(sock, &mh, MSG_NOSIGNAL)
+                              : send(sock, (const char *) msg + sent, size - sent, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return -1;
+        sent += (size_t) k;
+    }
+    return 0;
+}
+
+int gridd_recv(int sock, void *msg, size_t size, int *fd) {
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    if (fd) *fd = -1;
+    size_t got = 0;
+    while (got < size) {
+        struct iovec iov = {(char *) msg + got, size - got};
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        mh.msg_control = control.buf;
+        mh.msg_controllen = sizeof(control.buf);
+        ssize_t k = recvmsg(sock, &mh, MSG_CMSG_CLOEXEC);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) {
+            // Обрив або тайм-аут посеред повідомлення: отриманий дескриптор не потрібен
+            if (fd && *fd >= 0) {
+                close(*fd);
+                *fd = -1;
+            }
+            return -1;
+        }
+        for (struct cmsghdr *c = CMSG_FIRSTHDR(&mh); c; c = CMSG_NXTHDR(&mh, c)) {
+            if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+            int received;
+            memcpy(&received, CMSG_DATA(c), sizeof(int));
+            if (fd && *fd < 0) *fd = received;
+            else close(received);
+        }
+        got += (size_t) k;
+    }
+    return 0;
+}
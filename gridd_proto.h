@@ -0,0 +1,70 @@
+#ifndef GRIDD_PROTO_H
+#define GRIDD_PROTO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Двійковий протокол демона gridd поверх Unix-сокета SOCK_STREAM. Клієнт
+// шле gridd_request фіксованого розміру, демон відповідає gridd_response;
+// клітинки (для GRID і REGION) — не в сокеті, а у файлі memfd, дескриптор
+// якого йде разом з відповіддю через SCM_RIGHTS. Файл запечатаний від запису:
+// клієнт відображає його лише для читання, а демон без копіювання віддає той
+// самий файл усім, хто повторить запит. Порядок байтів — рідний, обидва боки
+// на одній машині.
+
+#define GRIDD_MAGIC 0x44475352u     // "RSGD"
+#define GRIDD_VERSION 1
+#define GRIDD_SOCKET_DEFAULT "/tmp/rsagrid.sock"
+
+typedef enum {
+    GRIDD_OP_GRID = 1,      // уся сітка + редукції
+    GRIDD_OP_REGION = 2,    // прямокутник + редукції по ньому
+    GRIDD_OP_STATS = 3,     // лише редукції, без клітинок
+    GRIDD_OP_SHUTDOWN = 4,
+} gridd_op;
+
+typedef enum {
+    GRIDD_OK = 0,
+    GRIDD_EBADREQ = 1,      // некоректний запит: розміри, ядро, версія
+    GRIDD_ENOMEM = 2,
+    GRIDD_EINTERNAL = 3,
+} gridd_status;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t op;
+    uint64_t n, e;          // 0 — n_const / e_const драйверів
+    uint64_t col_step;      // 0 — width (формула diag)
+    uint32_t width, height;
+    uint32_t kernel;        // grid_kernel
+    uint32_t ilp;           // 1..ILP_MAX; 0 — 1
+    uint32_t row, col, rows, cols;  // для GRIDD_OP_REGION
+    uint32_t flags;         // GRIDD_NO_CACHE
+} gridd_request;
+
+// Обчислити заново, навіть якщо результат є в кеші (для вимірювань)
+#define GRIDD_NO_CACHE 1u
+
+#define GRIDD_PROBES 5
+
+typedef struct {
+    uint32_t magic;
+    uint32_t status;        // gridd_status
+    uint32_t cached;        // відповідь з кешу результатів
+    uint32_t has_fd;        // разом з відповіддю прийшов дескриптор memfd
+    uint32_t workers;       // виконавців пулу демона
+    uint32_t rows, cols;    // форма клітинок у memfd, рядки підряд
+    uint64_t bytes;
+    uint64_t min, max;
+    uint64_t probes[GRIDD_PROBES];
+    uint64_t fingerprint_a, fingerprint_b;
+    double seconds;         // час обчислення в демоні (0 для кешу)
+} gridd_response;
+
+// Повертають 0 або -1 (розрив з'єднання, тайм-аут сокета чи інша помилка)
+int gridd_send(int sock, const void *msg, size_t size, int fd);
+// *fd отримує переданий дескриптор або -1
+int gridd_recv(int sock, void *msg, size_t size, int *fd);
+
+#endif
@@ -0,0 +1,258 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gridfile.h"
+
+void gridfile_header_init(gridfile_header *hdr, const modexp_plan *plan, int width, int height, ull col_step) {
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = GRIDFILE_MAGIC;
+    hdr->version = GRIDFILE_VERSION;
+    hdr->width = (uint32_t) width;
+    hdr->height = (uint32_t) height;
+    hdr->n = plan->n;
+    hdr->e = plan->e;
+    hdr->row_step = (ull) width;
+    hdr->col_step = col_step;
+    hdr->exact = plan->kernel != KERNEL_LEGACY;
+}
+
+int gridfile_create(gridfile_writer *w, const char *path, const gridfile_header *hdr) {
+    memset(w, 0, sizeof(*w));
+    w->hdr = *hdr;
+    w->hdr.min = w->hdr.max = w->hdr.fp_a = w->hdr.fp_b = 0;
+    size_t len = strlen(path);
+    w->path = strdup(path);
+    w->tmp = malloc(len + 5);
+    if (!w->path || !w->tmp) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        gridfile_abort(w);
+        return -1;
+    }
+    memcpy(w->tmp, path, len);
+    memcpy(w->tmp + len, ".tmp", 5);
+    w->out = fopen(w->tmp, "wb");
+    // Заголовок поки що порожній: min/max і відбиток відомі лише в кінці
+    if (!w->out || fwrite(&w->hdr, sizeof(w->hdr), 1, w->out) != 1) {
+        perror(w->tmp);
+        gridfile_abort(w);
+        return -1;
+    }
+    return 0;
+}
+
+int gridfile_write_rows(gridfile_writer *w, const ull *rows, int count) {
+    int width = (int) w->hdr.width, height = (int) w->hdr.height;
+    for (int r = 0; r < count; r++) {
+        int i = w->next_row + r;
+        const ull *row = &rows[(size_t) r * width];
+        if (i >= w->hash_from) {
+            grid_fingerprint fp = fingerprint_row((ull) i * width, row, width);
+            w->hdr.fp_a += fp.a;
+            w->hdr.fp_b += fp.b;
+        }
+        // Ті самі клітинки, що й у grid_probes
+        if (i == 0) {
+            w->probes[0] = row[0];
+            w->probes[1] = row[width - 1];
+        }
+        if (i == height - 1) {
+            w->probes[2] = row[0];
+            w->probes[3] = row[width - 1];
+        }
+        if (i == height / 2) w->probes[4] = row[width / 2];
+    }
+    if (fwrite(rows, sizeof(ull) * width, count, w->out) != (size_t) count) {
+        perror(w->tmp);
+        return -1;
+    }
+    w->next_row += count;
+    return 0;
+}
+
+int gridfile_finish(gridfile_writer *w, ull min, ull max) {
+    int rc = 0;
+    w->hdr.min = min;
+    w->hdr.max = max;
+    if (w->next_row != (int) w->hdr.height) {
+        fprintf(stderr, "%s: записано %d рядків із %u\n", w->tmp, w->next_row, w->hdr.height);
+        rc = -1;
+    } else if (fseek(w->out, 0, SEEK_SET) != 0 || fwrite(&w->hdr, sizeof(w->hdr), 1, w->out) != 1 ||
+               fflush(w->out) != 0) {
+        perror(w->tmp);
+        rc = -1;
+    }
+    if (fclose(w->out) != 0 && rc == 0) {
+        perror(w->tmp);
+        rc = -1;
+    }
+    w->out = NULL;
+    if (rc == 0 && rename(w->tmp, w->path) != 0) {
+        perror(w->path);
+        rc = -1;
+    }
+    if (rc != 0) unlink(w->tmp);
+    free(w->path);
+    free(w->tmp);
+    w->path = w->tmp = NULL;
+    return rc;
+}
+
+void gridfile_abort(gridfile_writer *w) {
+    if (w->out) {
+        fclose(w->out);
+        unlink(w->tmp);
+    }
+    free(w->path);
+    free(w->tmp);
+    memset(w, 0, sizeof(*w));
+}
+
+int gridfile_save(const char *path, const gridfile_header *hdr, const grid_layout *l, const ull *data,
+                  ull min, ull max) {
+    gridfile_writer w;
+    if (gridfile_create(&w, path, hdr) != 0) return -1;
+    if (l->kind == LAYOUT_ROW) {
+        if (gridfile_write_rows(&w, data, l->height) != 0) {
+            gridfile_abort(&w);
+            return -1;
+        }
+        return gridfile_finish(&w, min, max);
+    }
+    // Плиткова розкладка збирається в рядок відрізками
+    ull *row = malloc((size_t) l->width * sizeof(ull));
+    if (!row) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        gridfile_abort(&w);
+        return -1;
+    }
+    for (int i = 0; i < l->height; i++) {
+        for (int j = 0; j < l->width;) {
+            int len;
+            const ull *run = grid_layout_run(l, (ull *) data, i, j, &len);
+            memcpy(&row[j], run, len * sizeof(ull));
+            j += len;
+        }
+        if (gridfile_write_rows(&w, row, 1) != 0) {
+            free(row);
+            gridfile_abort(&w);
+            return -1;
+        }
+    }
+    free(row);
+    return gridfile_finish(&w, min, max);
+}
+
+int gridfile_open(gridfile_map *m, const char *path) {
+    memset(m, 0, sizeof(*m));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if ((size_t) st.st_size < sizeof(gridfile_header) ||
+        pread(fd, &m->hdr, sizeof(m->hdr), 0) != (ssize_t) sizeof(m->hdr) ||
+        m->hdr.magic != GRIDFILE_MAGIC || m->hdr.version != GRIDFILE_VERSION ||
+        m->hdr.width == 0 || m->hdr.height == 0 ||
+        (size_t) st.st_size != sizeof(gridfile_header) + (size_t) m->hdr.width * m->hdr.height * sizeof(ull)) {
+        fprintf(stderr, "%s: не файл сітки або пошкоджений\n", path);
+        close(fd);
+        return -1;
+    }
+    m->bytes = (size_t) st.st_size;
+    m->map = mmap(NULL, m->bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m->map == MAP_FAILED) {
+        perror(path);
+        m->map = NULL;
+        return -1;
+    }
+    // Файл читається один раз від початку до кінця
+    madvise(m->map, m->bytes, MADV_SEQUENTIAL);
+    m->cells = (const ull *) ((const char *) m->map + sizeof(gridfile_header));
+    return 0;
+}
+
+void gridfile_close(gridfile_map *m) {
+    if (m->map) munmap(m->map, m->bytes);
+    m->map = NULL;
+}
+
+int grid_extension_init(grid_extension *x, const modexp_plan *plan, const gridfile_map *old,
+                        int width, int height) {
+    const gridfile_header *h = &old->hdr;
+    memset(x, 0, sizeof(*x));
+    if (h->n != plan->n || h->e != plan->e) {
+        fprintf(stderr, "Файл порахований з n = %llu, e = %llu, а драйвер — з n = %llu, e = %llu (див. --e)\n",
+                h->n, h->e, plan->n, plan->e);
+        return -1;
+    }
+    if (h->exact != (uint32_t) (plan->kernel != KERNEL_LEGACY)) {
+        fprintf(stderr, "Файл порахований %s ядром, а legacy і точні ядра дають різні клітинки\n",
+                h->exact ? "точним" : "legacy");
+        return -1;
+    }
+    if ((ull) width < h->width || (ull) height < h->height) {
+        fprintf(stderr, "Розширення не зменшує сітку: у файлі %ux%u, запитано %dx%d\n",
+                h->width, h->height, width, height);
+        return -1;
+    }
+    x->plan = plan;
+    x->old = old;
+    x->width = width;
+    x->height = height;
+    x->old_width = (int) h->width;
+    x->old_height = (int) h->height;
+    x->row_step = h->row_step;
+    x->col_step = h->col_step;
+    return 0;
+}
+
+int grid_extension_begin(const grid_extension *x, gridfile_writer *w, const char *path, ull *min, ull *max) {
+    *min = x->old->hdr.min;
+    *max = x->old->hdr.max;
+    if (!w) return 0;
+    gridfile_header hdr = x->old->hdr;
+    hdr.width = (uint32_t) x->width;
+    hdr.height = (uint32_t) x->height;
+    if (gridfile_create(w, path, &hdr) != 0) return -1;
+    // Індекси старих клітинок у відбитку змінюються лише разом із шириною
+    if (x->width == x->old_width) {
+        w->hdr.fp_a = x->old->hdr.fp_a;
+        w->hdr.fp_b = x->old->hdr.fp_b;
+        w->hash_from = x->old_height;
+    }
+    return 0;
+}
+
+int grid_extension_finish(const grid_extension *x, gridfile_writer *w, const grid_options *opts,
+                          grid_summary *s, long long computed, ull min, ull max) {
+    printf("Розширено %dx%d до %dx%d за %.3f с: зашифровано %lld нових клітинок, "
+           "%lld взято з файлу\n", x->old_width, x->old_height, x->width, x->height, s->seconds,
+           computed, (long long) x->old_width * x->old_height);
+    s->width = x->width;
+    s->height = x->height;
+    s->e = x->old->hdr.e;
+    s->col_step = x->col_step;
+    s->min = min;
+    s->max = max;
+    memcpy(s->probes, w->probes, sizeof(s->probes));
+    s->has_fingerprint = 1;
+    s->fingerprint = gridfile_fingerprint(w);
+    int rc = gridfile_finish(w, min, max) == 0 ? 0 : 1;
+    if (rc == 0)
+        printf("Записано %s. min = %llu, max = %llu\n", opts->output ? opts->output : opts->extend, min, max);
+
+    printf("Верхній лівий: %llu\n", s->probes[0]);
+    printf("Верхній правий: %llu\n", s->probes[1]);
+    printf("Нижній лівий: %llu\n", s->probes[2]);
+    printf("Нижній правий: %llu\n", s->probes[3]);
+    printf("Центр: %llu\n", s->probes[4]);
+    if (report_fingerprint(&s->fingerprint, opts->golden) != 0 && rc == 0) rc = 3;
+    if (opts->summary) print_summary(s);
+    return rc;
+}
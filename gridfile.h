@@ -0,0 +1,115 @@
+#ifndef GRIDFILE_H
+#define GRIDFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "options.h"
+#include "report.h"
+
+// Файл результату (--output, --extend): заголовок GRIDFILE_HEADER_BYTES і
+// клітинки построково, width * height чисел ull у порядку байтів машини.
+// Заголовок зберігає все, що потрібно, щоб дорахувати більшу сітку без
+// повторного шифрування: параметри повідомлень, min/max і суму відбитка.
+#define GRIDFILE_MAGIC 0x44495247u      // "GRID"
+#define GRIDFILE_VERSION 2
+#define GRIDFILE_HEADER_BYTES 128
+
+typedef struct {
+    uint32_t magic, version;
+    uint32_t width, height;
+    ull n, e;
+    ull row_step, col_step;     // повідомлення клітинки (i, j) — i * row_step + j * col_step
+    uint32_t exact;             // 1 — точні ядра, 0 — legacy з переповненням (інші значення)
+    uint32_t reserved;
+    ull min, max;
+    ull fp_a, fp_b;             // сума відбитка до fingerprint_finish
+    unsigned char pad[GRIDFILE_HEADER_BYTES - 88];
+} gridfile_header;
+
+_Static_assert(sizeof(gridfile_header) == GRIDFILE_HEADER_BYTES, "заголовок файлу сітки");
+
+// Послідовний запис рядків у PATH.tmp; gridfile_finish дописує заголовок і
+// перейменовує файл, тож PATH можна перезаписати тим самим, що розширюється.
+// Відбиток і контрольні клітинки рахуються з рядків на льоту.
+typedef struct {
+    FILE *out;
+    char *path, *tmp;
+    gridfile_header hdr;
+    int next_row;
+    int hash_from;              // рядки до hash_from уже враховані у hdr.fp_a, hdr.fp_b
+    ull probes[GRID_PROBES];
+} gridfile_writer;
+
+// hdr: розміри, n, e, кроки та exact; решта заповнюється під час запису.
+// Повертає 0 або -1 з повідомленням у stderr.
+int gridfile_create(gridfile_writer *w, const char *path, const gridfile_header *hdr);
+int gridfile_write_rows(gridfile_writer *w, const ull *rows, int count);
+int gridfile_finish(gridfile_writer *w, ull min, ull max);
+void gridfile_abort(gridfile_writer *w);
+
+static inline grid_fingerprint gridfile_fingerprint(const gridfile_writer *w) {
+    grid_fingerprint sum = {w->hdr.fp_a, w->hdr.fp_b};
+    return fingerprint_finish(sum, (int) w->hdr.width, (int) w->hdr.height);
+}
+
+// Заголовок звичайного прогону: row_step — ширина сітки
+void gridfile_header_init(gridfile_header *hdr, const modexp_plan *plan, int width, int height, ull col_step);
+
+// Уся сітка з пам'яті в довільній розкладці
+int gridfile_save(const char *path, const gridfile_header *hdr, const grid_layout *l, const ull *data,
+                  ull min, ull max);
+
+// Відображений у пам'ять файл для читання
+typedef struct {
+    gridfile_header hdr;
+    const ull *cells;
+    void *map;
+    size_t bytes;
+} gridfile_map;
+
+int gridfile_open(gridfile_map *m, const char *path);
+void gridfile_close(gridfile_map *m);
+
+// Розширення збереженої сітки (--extend): клітинки, що вже є у файлі,
+// копіюються, шифруються лише нові рядки та стовпці. Повідомлення нових
+// клітинок — за кроками з файлу, тож результат збігається з сіткою, яку з
+// тими ж кроками порахували б з нуля.
+typedef struct {
+    const modexp_plan *plan;
+    const gridfile_map *old;
+    int width, height;          // нові розміри, не менші за збережені
+    int old_width, old_height;
+    ull row_step, col_step;
+} grid_extension;
+
+// Перевіряє сумісність файлу з планом і розмірами; 0 або -1 з повідомленням
+int grid_extension_init(grid_extension *x, const modexp_plan *plan, const gridfile_map *old,
+                        int width, int height);
+
+// Починає запис результату (w може бути NULL для процесів без виводу) і
+// задає початкові min/max зі збережених значень. За тієї ж ширини сума
+// відбитка продовжується із заголовка, інакше старі клітинки хешуються
+// наново під новими індексами.
+int grid_extension_begin(const grid_extension *x, gridfile_writer *w, const char *path, ull *min, ull *max);
+
+// Рядок i нової сітки в row: старий префікс з файлу, решта шифрується.
+// Повертає кількість нових клітинок.
+static inline long long grid_extension_row(const grid_extension *x, int i, ull *row, ull *min, ull *max) {
+    int first = 0;
+    if (i < x->old_height) {
+        const ull *src = &x->old->cells[(size_t) i * x->old_width];
+        for (int j = 0; j < x->old_width; j++) row[j] = src[j];
+        first = x->old_width;
+    }
+    if (first == x->width) return 0;
+    plan_encrypt_row(x->plan, (ull) i * x->row_step + (ull) first * x->col_step, x->col_step,
+                     row + first, x->width - first, min, max);
+    return x->width - first;
+}
+
+// Завершує запис і друкує звіт як у драйверів; s — backend, workers, kernel,
+// ilp та seconds від драйвера. Повертає код виходу: 0, 1 (запис) чи 3 (еталон).
+int grid_extension_finish(const grid_extension *x, gridfile_writer *w, const grid_options *opts,
+                          grid_summary *s, long long computed, ull min, ull max);
+
+#endif
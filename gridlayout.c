@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gridlayout.h"
+
+// Одиниць перетворення в задачі пулу: плитка 32 x 32 — лише 8 КБ
+#define CONVERT_UNITS_PER_TASK 16
+
+// Чергує біти x і y: код Мортона плитки (y — старші біти пар)
+static ull morton_code(unsigned int x, unsigned int y) {
+    ull code = 0;
+    for (int b = 0; b < 32; b++) {
+        code |= (ull) ((x >> b) & 1) << (2 * b);
+        code |= (ull) ((y >> b) & 1) << (2 * b + 1);
+    }
+    return code;
+}
+
+typedef struct {
+    ull code;
+    int tile;
+} morton_entry;
+
+static int cmp_morton(const void *a, const void *b) {
+    ull x = ((const morton_entry *) a)->code, y = ((const morton_entry *) b)->code;
+    return (x > y) - (x < y);
+}
+
+int grid_layout_init(grid_layout *l, grid_layout_kind kind, int width, int height, int tile) {
+    memset(l, 0, sizeof(*l));
+    l->kind = kind;
+    l->width = width;
+    l->height = height;
+    if (kind == LAYOUT_ROW) return 0;
+
+    if (tile == 0) tile = LAYOUT_TILE_DEFAULT;
+    if (tile < 2 || tile > 4096 || (tile & (tile - 1)) != 0) {
+        fprintf(stderr, "Сторона плитки має бути степенем двійки від 2 до 4096: %d\n", tile);
+        return -1;
+    }
+    l->tile = tile;
+    while ((1 << l->shift) < tile) l->shift++;
+    l->tiles_x = (width + tile - 1) / tile;
+    l->tiles_y = (height + tile - 1) / tile;
+    int count = l->tiles_x * l->tiles_y;
+    l->slot = malloc(count * sizeof(int));
+    l->origin = malloc(count * sizeof(int));
+    morton_entry *order = kind == LAYOUT_MORTON ? malloc(count * sizeof(morton_entry)) : NULL;
+    if (!l->slot || !l->origin || (kind == LAYOUT_MORTON && !order)) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        free(order);
+        grid_layout_free(l);
+        return -1;
+    }
+
+    // Для непарних розмірів Z-крива обходить описаний квадрат, а відсутні
+    // плитки просто пропускаються — місця в пам'яті йдуть підряд
+    for (int t = 0; t < count; t++) {
+        if (order) order[t] = (morton_entry) {morton_code(t % l->tiles_x, t / l->tiles_x), t};
+        else l->origin[t] = t;
+    }
+    if (order) {
+        qsort(order, count, sizeof(morton_entry), cmp_morton);
+        for (int s = 0; s < count; s++) l->origin[s] = order[s].tile;
+        free(order);
+    }
+    for (int s = 0; s < count; s++) l->slot[l->origin[s]] = s;
+    return 0;
+}
+
+void grid_layout_free(grid_layout *l) {
+    free(l->slot);
+    free(l->origin);
+    l->slot = l->origin = NULL;
+}
+
+const char *grid_layout_name(grid_layout_kind kind) {
+    switch (kind) {
+        case LAYOUT_TILED: return "tiled";
+        case LAYOUT_MORTON: return "morton";
+        default: return "row";
+    }
+}
+
+size_t grid_layout_cells(const grid_layout *l) {
+    if (l->kind == LAYOUT_ROW) return (size_t) l->width * l->height;
+    return (size_t) l->tiles_x * l->tiles_y << (2 * l->shift);
+}
+
+int grid_layout_units(const grid_layout *l) {
+    return l->kind == LAYOUT_ROW ? l->height : l->tiles_x * l->tiles_y;
+}
+
+void grid_layout_unit_rect(const grid_layout *l, int unit, int *i0, int *i1, int *j0, int *j1) {
+    if (l->kind == LAYOUT_ROW) {
+        *i0 = unit;
+        *i1 = unit + 1;
+        *j0 = 0;
+        *j1 = l->width;
+        return;
+    }
+    int t = l->origin[unit];
+    *i0 = t / l->tiles_x * l->tile;
+    *j0 = t % l->tiles_x * l->tile;
+    *i1 = *i0 + l->tile < l->height ? *i0 + l->tile : l->height;
+    *j1 = *j0 + l->tile < l->width ? *j0 + l->tile : l->width;
+}
+
+void grid_layout_to_rows(const grid_layout *l, const ull *data, ull *rows, int first, int last) {
+    for (int u = first; u < last; u++) {
+        int i0, i1, j0, j1;
+        grid_layout_unit_rect(l, u, &i0, &i1, &j0, &j1);
+        for (int i = i0; i < i1; i++)
+            memcpy(&rows[(size_t) i * l->width + j0], &data[grid_layout_index(l, i, j0)],
+                   (size_t) (j1 - j0) * sizeof(ull));
+    }
+}
+
+void grid_layout_from_rows(const grid_layout *l, const ull *rows, ull *data, int first, int last) {
+    for (int u = first; u < last; u++) {
+        int i0, i1, j0, j1;
+        grid_layout_unit_rect(l, u, &i0, &i1, &j0, &j1);
+        for (int i = i0; i < i1; i++)
+            memcpy(&data[grid_layout_index(l, i, j0)], &rows[(size_t) i * l->width + j0],
+                   (size_t) (j1 - j0) * sizeof(ull));
+    }
+}
+
+typedef struct {
+    const grid_layout *l;
+    const ull *src;
+    ull *dst;
+    int to_rows;
+} convert_ctx;
+
+static void convert_task(void *arg, long task, int worker) {
+    const convert_ctx *c = arg;
+    (void) worker;
+    int units = grid_layout_units(c->l);
+    int first = (int) task * CONVERT_UNITS_PER_TASK;
+    int last = first + CONVERT_UNITS_PER_TASK < units ? first + CONVERT_UNITS_PER_TASK : units;
+    if (c->to_rows) grid_layout_to_rows(c->l, c->src, c->dst, first, last);
+    else grid_layout_from_rows(c->l, c->src, c->dst, first, last);
+}
+
+void grid_layout_convert(workpool *pool, const grid_layout *l, const ull *src, ull *dst, int to_rows) {
+    convert_ctx ctx = {l, src, dst, to_rows};
+    long tasks = (grid_layout_units(l) + CONVERT_UNITS_PER_TASK - 1) / CONVERT_UNITS_PER_TASK;
+    if (!pool) {
+        for (long t = 0; t < tasks; t++) convert_task(&ctx, t, 0);
+        return;
+    }
+    workpool_run(pool, tasks, convert_task, &ctx);
+}
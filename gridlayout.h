@@ -0,0 +1,103 @@
+#ifndef GRIDLAYOUT_H
+#define GRIDLAYOUT_H
+
+#include <stddef.h>
+#include "rsa.h"
+#include "fingerprint.h"
+#include "workpool.h"
+
+// Розкладка сітки в пам'яті. Крім звичайної построкової — квадратні плитки
+// tile x tile клітинок, кожна неперервним блоком (рядки плитки підряд), самі
+// плитки — построково або в порядку Мортона (Z-крива). Сусідні за обома
+// вимірами клітинки тоді лежать на спільних кеш-лініях і сторінках, тож
+// читання прямокутної області торкається значно меншої кількості пам'яті.
+// Крайові плитки зберігаються повними, клітинки за межами сітки не заповнюються.
+typedef enum {
+    LAYOUT_ROW,         // data[i * width + j], як раніше
+    LAYOUT_TILED,       // плитки построково
+    LAYOUT_MORTON,      // плитки в порядку Мортона
+} grid_layout_kind;
+
+// Сторона плитки за замовчуванням: 32 x 32 x 8 байт = 8 КБ, дві сторінки
+#define LAYOUT_TILE_DEFAULT 32
+
+typedef struct {
+    grid_layout_kind kind;
+    int width, height;
+    int tile, shift;            // сторона плитки, степінь двійки, та її log2
+    int tiles_x, tiles_y;
+    int *slot;                  // номер плитки (ty * tiles_x + tx) -> місце в пам'яті
+    int *origin;                // місце в пам'яті -> номер плитки
+} grid_layout;
+
+// tile ігнорується для LAYOUT_ROW; 0 — LAYOUT_TILE_DEFAULT.
+// Повертає 0 або -1 з повідомленням у stderr.
+int grid_layout_init(grid_layout *l, grid_layout_kind kind, int width, int height, int tile);
+void grid_layout_free(grid_layout *l);
+
+const char *grid_layout_name(grid_layout_kind kind);
+
+// Клітинок у буфері разом із доповненням крайових плиток
+size_t grid_layout_cells(const grid_layout *l);
+
+// Кількість плиток (для LAYOUT_ROW — рядків): одиниць, які обчислюють і
+// перетворюють незалежно
+int grid_layout_units(const grid_layout *l);
+
+static inline size_t grid_layout_index(const grid_layout *l, int i, int j) {
+    if (l->kind == LAYOUT_ROW) return (size_t) i * l->width + j;
+    int ty = i >> l->shift, tx = j >> l->shift;
+    int mask = l->tile - 1;
+    size_t base = (size_t) l->slot[ty * l->tiles_x + tx] << (2 * l->shift);
+    return base + ((size_t) (i & mask) << l->shift) + (j & mask);
+}
+
+static inline ull grid_layout_at(const grid_layout *l, const ull *data, int i, int j) {
+    return data[grid_layout_index(l, i, j)];
+}
+
+// Неперервний відрізок рядка i від стовпця j до кінця плитки (або рядка
+// для LAYOUT_ROW); його довжина — у *len
+static inline ull *grid_layout_run(const grid_layout *l, ull *data, int i, int j, int *len) {
+    int end = l->kind == LAYOUT_ROW ? l->width : ((j >> l->shift) + 1) << l->shift;
+    if (end > l->width) end = l->width;
+    *len = end - j;
+    return &data[grid_layout_index(l, i, j)];
+}
+
+// Прямокутник одиниці unit у порядку зберігання: рядки [*i0, *i1), стовпці [*j0, *j1)
+void grid_layout_unit_rect(const grid_layout *l, int unit, int *i0, int *i1, int *j0, int *j1);
+
+// Шифрує одиницю unit на місці відрізками рядків, повідомлення клітинки
+// (i, j) — i * width + j * col_step, як у plan_encrypt_row. Внесок у
+// відбиток (якщо fp не NULL) — той самий, що й у построковій розкладці.
+// Повертає кількість клітинок.
+static inline long long layout_encrypt_unit(const grid_layout *l, const modexp_plan *plan, ull col_step,
+                                            ull *data, int unit, ull *min, ull *max, grid_fingerprint *fp) {
+    int i0, i1, j0, j1;
+    grid_layout_unit_rect(l, unit, &i0, &i1, &j0, &j1);
+    for (int i = i0; i < i1; i++) {
+        ull *seg = &data[grid_layout_index(l, i, j0)];
+        plan_encrypt_row(plan, (ull) i * l->width + (ull) j0 * col_step, col_step, seg, j1 - j0, min, max);
+        if (fp) fingerprint_add(fp, fingerprint_row((ull) i * l->width + j0, seg, j1 - j0));
+    }
+    return (long long) (i1 - i0) * (j1 - j0);
+}
+
+// Клітинок в одиниці зберігання (для LAYOUT_ROW — рядок)
+static inline size_t grid_layout_unit_cells(const grid_layout *l) {
+    return l->kind == LAYOUT_ROW ? (size_t) l->width : (size_t) 1 << (2 * l->shift);
+}
+
+// Перетворення між построковою сіткою rows і розкладкою для одиниць
+// [first, last): кожна плитка копіюється рядок за рядком, тож обидві
+// сторони читаються й пишуться блоками, що вміщуються в L1. Різні одиниці
+// не перетинаються, тож діапазони можна роздати потокам.
+void grid_layout_to_rows(const grid_layout *l, const ull *data, ull *rows, int first, int last);
+void grid_layout_from_rows(const grid_layout *l, const ull *rows, ull *data, int first, int last);
+
+// Усі одиниці на пулі (NULL — у викликаючому потоці). to_rows: з розкладки
+// в построкову сітку, інакше навпаки.
+void grid_layout_convert(workpool *pool, const grid_layout *l, const ull *src, ull *dst, int to_rows);
+
+#endif
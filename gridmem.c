@@ -0,0 +1,72 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "gridmem.h"
+
+#define HUGE_PAGE (2UL << 20)
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << 26)
+#endif
+
+static size_t round_huge(size_t bytes) {
+    return (bytes + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+}
+
+// Анонімне відображення з початком на межі 2 МБ: із запасом, зайве обрізається
+static void *map_aligned(size_t bytes) {
+    size_t len = bytes + HUGE_PAGE;
+    char *raw = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    char *aligned = (char *) (((uintptr_t) raw + HUGE_PAGE - 1) & ~(uintptr_t) (HUGE_PAGE - 1));
+    if (aligned > raw) munmap(raw, aligned - raw);
+    size_t tail = (raw + len) - (aligned + bytes);
+    if (tail) munmap(aligned + bytes, tail);
+    return aligned;
+}
+
+ull *grid_buffer_alloc(grid_buffer *buf, size_t cells, grid_pages pages) {
+    buf->data = NULL;
+    buf->bytes = cells * sizeof(ull);
+    buf->pages = pages;
+    if (pages == PAGES_DEFAULT) {
+        buf->data = malloc(buf->bytes);
+        return buf->data;
+    }
+
+    buf->bytes = round_huge(buf->bytes);
+    if (pages == PAGES_HUGETLB) {
+        void *p = mmap(NULL, buf->bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+        if (p != MAP_FAILED) {
+            buf->data = p;
+            return buf->data;
+        }
+        fprintf(stderr, "MAP_HUGETLB недоступний (vm.nr_hugepages?), використовується THP\n");
+        buf->pages = PAGES_THP;
+    }
+
+    void *p = map_aligned(buf->bytes);
+    if (!p) return NULL;
+    // Лише порада: без THP у ядрі лишаються звичайні сторінки
+    madvise(p, buf->bytes, MADV_HUGEPAGE);
+    buf->data = p;
+    return buf->data;
+}
+
+void grid_buffer_free(grid_buffer *buf) {
+    if (!buf->data) return;
+    if (buf->pages == PAGES_DEFAULT) free(buf->data);
+    else munmap(buf->data, buf->bytes);
+    buf->data = NULL;
+}
+
+const char *grid_pages_name(grid_pages pages) {
+    switch (pages) {
+        case PAGES_THP: return "thp";
+        case PAGES_HUGETLB: return "hugetlb";
+        default: return "default";
+    }
+}
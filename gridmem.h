@@ -0,0 +1,47 @@
+#ifndef GRIDMEM_H
+#define GRIDMEM_H
+
+#include <stddef.h>
+#include "montgomery.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Сторінки для буферів сітки
+typedef enum {
+    PAGES_DEFAULT,      // malloc
+    PAGES_THP,          // mmap, вирівняний на 2 МБ, з madvise(MADV_HUGEPAGE)
+    PAGES_HUGETLB,      // MAP_HUGETLB з 2 МБ сторінок; без резерву — як PAGES_THP
+} grid_pages;
+
+typedef struct {
+    ull *data;
+    size_t bytes;       // розмір відображення для munmap
+    grid_pages pages;   // що вдалося отримати насправді
+} grid_buffer;
+
+// Повертає буфер на cells клітинок або NULL
+ull *grid_buffer_alloc(grid_buffer *buf, size_t cells, grid_pages pages);
+
+void grid_buffer_free(grid_buffer *buf);
+
+const char *grid_pages_name(grid_pages pages);
+
+// Запис повз кеш (movnti): рядок сітки пишеться один раз і під час
+// обчислення не читається, тож не варто витісняти ним робочі дані ядра
+static inline void grid_stream_store(ull *dst, ull value) {
+#if defined(__x86_64__)
+    _mm_stream_si64((long long *) dst, (long long) value);
+#else
+    *dst = value;
+#endif
+}
+
+// Впорядковує потокові записи перед тим, як рядок побачать інші потоки
+static inline void grid_stream_fence(void) {
+#if defined(__x86_64__)
+    _mm_sfence();
+#endif
+}
+
+#endif
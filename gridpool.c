@@ -0,0 +1,142 @@
+#include <stdatomic.h>
+#include "gridpool.h"
+#include "timing.h"
+
+// Кожне поле на власній кеш-лінії: виконавці оновлюють їх раз на задачу
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic ull min;
+    _Alignas(CACHE_LINE) _Atomic ull max;
+    _Alignas(CACHE_LINE) _Atomic ull fp_a;
+    _Atomic ull fp_b;
+} pool_reduction;
+
+typedef struct {
+    const grid_pool_job *job;
+    int row0, rows, col0, cols;     // прямокутник з job або вся сітка
+    pool_reduction red;
+} pool_ctx;
+
+static void atomic_min_ull(_Atomic ull *target, ull value) {
+    ull cur = atomic_load_explicit(target, memory_order_relaxed);
+    while (value < cur && !atomic_compare_exchange_weak_explicit(target, &cur, value, memory_order_relaxed,
+                                                                  memory_order_relaxed)) {
+    }
+}
+
+static void atomic_max_ull(_Atomic ull *target, ull value) {
+    ull cur = atomic_load_explicit(target, memory_order_relaxed);
+    while (value > cur && !atomic_compare_exchange_weak_explicit(target, &cur, value, memory_order_relaxed,
+                                                                  memory_order_relaxed)) {
+    }
+}
+
+static void encrypt_tile(void *arg, long task, int worker) {
+    pool_ctx *ctx = arg;
+    const grid_pool_job *job = ctx->job;
+    const int width = job->width;
+    const int cols = ctx->cols;
+    int first = ctx->row0 + (int) task * job->tile_rows;
+    int end = ctx->row0 + ctx->rows;
+    int last = first + job->tile_rows < end ? first + job->tile_rows : end;
+
+    trace_ring *ring = job->trace ? trace_thread(job->trace, worker) : NULL;
+    long long tile_begin = ring ? trace_now() : 0;
+    double start = job->stats ? wall_now() : 0.0;
+
+    size_t stride = job->data ? (job->stride ? job->stride : (size_t) cols) : (size_t) cols;
+    ull *cells = job->data ? &job->data[(size_t) (first - ctx->row0) * stride]
+                           : &job->scratch[(size_t) worker * job->tile_rows * cols];
+
+    // Локальні min/max/відбиток, в атомарні змінні — раз на задачу
+    ull lo = job->plan->n, hi = 0;
+    grid_fingerprint fp = {0, 0};
+    for (int i = first; i < last; i++) {
+        ull *row = &cells[(size_t) (i - first) * stride];
+        ull first_index = (ull) i * width + ctx->col0;
+        plan_encrypt_row(job->plan, (ull) i * width + ctx->col0 * job->col_step, job->col_step,
+                         row, cols, &lo, &hi);
+        if (job->checksum) fingerprint_add(&fp, fingerprint_row(first_index, row, cols));
+        if (job->progress) progress_row_done(&job->progress[worker]);
+    }
+    if (job->on_tile) job->on_tile(job->tile_ctx, first, last - first, cells, stride, worker);
+    atomic_min_ull(&ctx->red.min, lo);
+    atomic_max_ull(&ctx->red.max, hi);
+    if (job->checksum) {
+        atomic_fetch_add_explicit(&ctx->red.fp_a, fp.a, memory_order_relaxed);
+        atomic_fetch_add_explicit(&ctx->red.fp_b, fp.b, memory_order_relaxed);
+    }
+
+    if (job->stats) {
+        thread_stats *s = &job->stats[worker];
+        s->rows += last - first;
+        s->cells += (long long) (last - first) * cols;
+        s->chunks++;
+        s->busy += wall_now() - start;
+    }
+    if (ring) trace_record(ring, TRACE_ROWS, tile_begin, trace_now(), first, last - first);
+}
+
+// Плитка розкладки на місці: один неперервний блок пам'яті на задачу
+static void encrypt_unit(void *arg, long task, int worker) {
+    pool_ctx *ctx = arg;
+    const grid_pool_job *job = ctx->job;
+    trace_ring *ring = job->trace ? trace_thread(job->trace, worker) : NULL;
+    long long tile_begin = ring ? trace_now() : 0;
+    double start = job->stats ? wall_now() : 0.0;
+
+    ull lo = job->plan->n, hi = 0;
+    grid_fingerprint fp = {0, 0};
+    long long cells = layout_encrypt_unit(job->layout, job->plan, job->col_step, job->data, (int) task,
+                                          &lo, &hi, job->checksum ? &fp : NULL);
+    if (job->progress) progress_row_done(&job->progress[worker]);
+    atomic_min_ull(&ctx->red.min, lo);
+    atomic_max_ull(&ctx->red.max, hi);
+    if (job->checksum) {
+        atomic_fetch_add_explicit(&ctx->red.fp_a, fp.a, memory_order_relaxed);
+        atomic_fetch_add_explicit(&ctx->red.fp_b, fp.b, memory_order_relaxed);
+    }
+
+    if (job->stats) {
+        thread_stats *s = &job->stats[worker];
+        s->rows++;
+        s->cells += cells;
+        s->chunks++;
+        s->busy += wall_now() - start;
+    }
+    if (ring) trace_record(ring, TRACE_TILE, tile_begin, trace_now(), task, 1);
+}
+
+void grid_pool_encrypt(workpool *pool, const grid_pool_job *job, grid_reduction *out) {
+    pool_ctx ctx;
+    ctx.job = job;
+    int whole = job->rows == 0;
+    ctx.row0 = whole ? 0 : job->row0;
+    ctx.rows = whole ? job->height : job->rows;
+    ctx.col0 = whole ? 0 : job->col0;
+    ctx.cols = whole ? job->width : job->cols;
+    atomic_init(&ctx.red.min, job->plan->n);
+    atomic_init(&ctx.red.max, 0);
+    atomic_init(&ctx.red.fp_a, 0);
+    atomic_init(&ctx.red.fp_b, 0);
+
+    long tiles = (ctx.rows + job->tile_rows - 1) / job->tile_rows;
+    pool_task task = encrypt_tile;
+    if (job->layout && job->layout->kind != LAYOUT_ROW) {
+        tiles = grid_layout_units(job->layout);
+        task = encrypt_unit;
+    }
+    if (!pool) {
+        for (long t = 0; t < tiles; t++) task(&ctx, t, 0);
+    } else {
+        workpool_run(pool, tiles, task, &ctx);
+    }
+
+    // workpool_run повертається після того, як усі виконавці пройшли м'ютекс пулу
+    out->min = atomic_load_explicit(&ctx.red.min, memory_order_relaxed);
+    out->max = atomic_load_explicit(&ctx.red.max, memory_order_relaxed);
+    out->fp.a = atomic_load_explicit(&ctx.red.fp_a, memory_order_relaxed);
+    out->fp.b = atomic_load_explicit(&ctx.red.fp_b, memory_order_relaxed);
+    if (job->stats && pool)
+        for (int w = 0; w < workpool_size(pool); w++)
+            job->stats[w].wait = workpool_worker_stats(pool, w).idle;
+}
@@ -0,0 +1,51 @@
+#ifndef GRIDPOOL_H
+#define GRIDPOOL_H
+
+#include "rsa.h"
+#include "fingerprint.h"
+#include "workpool.h"
+#include "thread_stats.h"
+#include "progress.h"
+#include "trace.h"
+#include "gridlayout.h"
+
+// Рядків у задачі пулу за замовчуванням
+#define POOL_TILE_ROWS 4
+
+// Готова плитка: рядки first..first+rows-1 (номери в повній сітці) на всю
+// ширину обчислюваного прямокутника, його стовпець j — cells[(i - first) * stride + j]. Викликається на виконавці одразу після
+// шифрування плитки, поки вона ще в кеші; виклики з різних виконавців паралельні.
+typedef void (*grid_tile_fn)(void *ctx, int first, int rows, const ull *cells, size_t stride, int worker);
+
+// Сітка на пулі workpool: задача — блок з tile_rows рядків. Усі покажчики
+// на масиви по виконавцях можуть бути NULL.
+typedef struct {
+    const modexp_plan *plan;
+    ull *data;                  // клітинка (row0, col0); NULL — плитки пишуться в scratch і живуть лише до on_tile
+    int width, height;
+    ull col_step;
+    int tile_rows;
+    int checksum;
+    thread_stats *stats;        // rows, cells, chunks (задач) і busy; wait — з workpool
+    progress_slot *progress;
+    const trace_log *trace;
+    size_t stride;              // крок рядків data у клітинках; 0 — ширина прямокутника
+    ull *scratch;               // без data: tile_rows * width клітинок на виконавця
+    int row0, rows, col0, cols; // прямокутник сітки; rows == 0 — уся сітка
+    grid_tile_fn on_tile;
+    void *tile_ctx;
+    const grid_layout *layout;  // плиткова розкладка: задача — плитка, лише вся сітка в data
+} grid_pool_job;
+
+typedef struct {
+    ull min, max;
+    grid_fingerprint fp;        // сума внесків рядків, без fingerprint_finish
+} grid_reduction;
+
+// Шифрує сітку (чи її прямокутник) і повертає min, max та відбиток. min/max і лани відбитка
+// виконавці об'єднують без блокувань: CAS для min/max, fetch_add для суми.
+// Без пулу (pool == NULL) задачі виконуються по черзі у викликаючому потоці
+// як виконавець 0.
+void grid_pool_encrypt(workpool *pool, const grid_pool_job *job, grid_reduction *out);
+
+#endif
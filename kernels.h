@@ -0,0 +1,324 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "montgomery.h"
+
+typedef long long ll;
+
+// Ядра піднесення до степеня за модулем для seq.c, openmp.c та mpi.c.
+// Гарячі функції — static inline, щоб компілятор вбудовував їх у цикли драйверів.
+
+// Класичне піднесення до степеня через `%`. Добуток (result * base) переповнює
+// 64 біти для n > 2^32, тому результат не є справжнім RSA — залишено як є,
+// щоб стандартний режим драйверів давав ті самі числа, що й раніше.
+static inline ull modexp(ull base, ull exp, ull mod) {
+    ull result = 1;
+    base %= mod;
+    while (exp > 0) {
+        if (exp & 1) result = (result * base) % mod;
+        exp >>= 1;
+        base = (base * base) % mod;
+    }
+    return result;
+}
+
+// Точне множення за модулем через 128-бітний добуток.
+static inline ull mulmod_u128(ull a, ull b, ull mod) {
+    return (ull) (((unsigned __int128) a * b) % mod);
+}
+
+static inline ull modexp_u128(ull base, ull exp, ull mod) {
+    ull result = 1;
+    base %= mod;
+    while (exp > 0) {
+        if (exp & 1) result = mulmod_u128(result, base, mod);
+        exp >>= 1;
+        base = mulmod_u128(base, base, mod);
+    }
+    return result;
+}
+
+// Редукція Барретта: mu = floor((2^128 - 1) / n), частка оцінюється старшою
+// половиною 256-бітного добутку x * mu без ділення.
+typedef struct {
+    ull n;
+    unsigned __int128 mu;
+} barrett_ctx;
+
+static inline void barrett_init(barrett_ctx *ctx, ull n) {
+    ctx->n = n;
+    ctx->mu = ~(unsigned __int128) 0 / n;
+}
+
+static inline ull barrett_reduce(const barrett_ctx *ctx, unsigned __int128 x) {
+    ull x0 = (ull) x, x1 = (ull) (x >> 64);
+    ull m0 = (ull) ctx->mu, m1 = (ull) (ctx->mu >> 64);
+    unsigned __int128 lo = (unsigned __int128) x0 * m0;
+    unsigned __int128 a = (unsigned __int128) x1 * m0;
+    unsigned __int128 b = (unsigned __int128) x0 * m1;
+    unsigned __int128 mid = (ull) a + (unsigned __int128) (ull) b + (ull) (lo >> 64);
+    ull q = (ull) ((unsigned __int128) x1 * m1 + (a >> 64) + (b >> 64) + (mid >> 64));
+    // Оцінка частки менша за справжню щонайбільше на 2
+    ull r = (ull) (x - (unsigned __int128) q * ctx->n);
+    while (r >= ctx->n) r -= ctx->n;
+    return r;
+}
+
+static inline ull mulmod_barrett(const barrett_ctx *ctx, ull a, ull b) {
+    return barrett_reduce(ctx, (unsigned __int128) a * b);
+}
+
+static inline ull modexp_barrett(const barrett_ctx *ctx, ull base, ull exp) {
+    ull result = 1 % ctx->n;
+    base %= ctx->n;
+    while (exp > 0) {
+        if (exp & 1) result = mulmod_barrett(ctx, result, base);
+        exp >>= 1;
+        base = mulmod_barrett(ctx, base, base);
+    }
+    return result;
+}
+
+// Швидке (не сталочасове) піднесення у формі Монтгомері: пропускає
+// множення на нульових бітах експоненти, на відміну від modexp_ladder.
+static inline ull modexp_mont(const mont_ctx *ctx, ull base, ull exp) {
+    ull result = ctx->r1;
+    base = mont_to(ctx, base);
+    while (exp > 0) {
+        if (exp & 1) result = mont_mul(ctx, result, base);
+        exp >>= 1;
+        base = mont_mul(ctx, base, base);
+    }
+    return mont_from(ctx, result);
+}
+
+// Скільки незалежних ланцюжків modexp може чергувати одне ядро (--ilp)
+#define ILP_MAX 8
+
+// Варіанти *_ilp рахують `w` повідомлень з однією експонентою одночасно.
+// Біт експоненти спільний для всіх ланцюжків, тож на кожному кроці
+// видаються `w` незалежних множень, і їхні затримки перекриваються.
+// Параметр `w` останній і має бути сталою у місці виклику (див. ILP_CALL).
+
+static inline __attribute__((always_inline))
+void modexp_ilp(const ull *base, ull *out, ull exp, ull mod, int w) {
+    ull result[ILP_MAX], b[ILP_MAX];
+    for (int k = 0; k < w; k++) {
+        result[k] = 1;
+        b[k] = base[k] % mod;
+    }
+    while (exp > 0) {
+        if (exp & 1)
+            for (int k = 0; k < w; k++) result[k] = (result[k] * b[k]) % mod;
+        exp >>= 1;
+        for (int k = 0; k < w; k++) b[k] = (b[k] * b[k]) % mod;
+    }
+    for (int k = 0; k < w; k++) out[k] = result[k];
+}
+
+static inline __attribute__((always_inline))
+void modexp_u128_ilp(const ull *base, ull *out, ull exp, ull mod, int w) {
+    ull result[ILP_MAX], b[ILP_MAX];
+    for (int k = 0; k < w; k++) {
+        result[k] = 1;
+        b[k] = base[k] % mod;
+    }
+    while (exp > 0) {
+        if (exp & 1)
+            for (int k = 0; k < w; k++) result[k] = mulmod_u128(result[k], b[k], mod);
+        exp >>= 1;
+        for (int k = 0; k < w; k++) b[k] = mulmod_u128(b[k], b[k], mod);
+    }
+    for (int k = 0; k < w; k++) out[k] = result[k];
+}
+
+static inline __attribute__((always_inline))
+void modexp_barrett_ilp(const barrett_ctx *ctx, const ull *base, ull *out, ull exp, int w) {
+    ull result[ILP_MAX], b[ILP_MAX];
+    for (int k = 0; k < w; k++) {
+        result[k] = 1 % ctx->n;
+        b[k] = base[k] % ctx->n;
+    }
+    while (exp > 0) {
+        if (exp & 1)
+            for (int k = 0; k < w; k++) result[k] = mulmod_barrett(ctx, result[k], b[k]);
+        exp >>= 1;
+        for (int k = 0; k < w; k++) b[k] = mulmod_barrett(ctx, b[k], b[k]);
+    }
+    for (int k = 0; k < w; k++) out[k] = result[k];
+}
+
+static inline __attribute__((always_inline))
+void modexp_mont_ilp(const mont_ctx *ctx, const ull *base, ull *out, ull exp, int w) {
+    ull result[ILP_MAX], b[ILP_MAX];
+    for (int k = 0; k < w; k++) {
+        result[k] = ctx->r1;
+        b[k] = mont_to(ctx, base[k]);
+    }
+    while (exp > 0) {
+        if (exp & 1)
+            for (int k = 0; k < w; k++) result[k] = mont_mul(ctx, result[k], b[k]);
+        exp >>= 1;
+        for (int k = 0; k < w; k++) b[k] = mont_mul(ctx, b[k], b[k]);
+    }
+    for (int k = 0; k < w; k++) out[k] = mont_from(ctx, result[k]);
+}
+
+// Маска обміну залежить лише від експоненти, тому спільна для всіх ланцюжків
+static inline __attribute__((always_inline))
+void modexp_ladder_ilp(const mont_ctx *ctx, const ull *base, ull *out, ull exp, int bits, int w) {
+    ull r0[ILP_MAX], r1[ILP_MAX];
+    for (int k = 0; k < w; k++) {
+        r0[k] = ctx->r1;
+        r1[k] = mont_to(ctx, base[k]);
+    }
+    for (int bit = bits - 1; bit >= 0; bit--) {
+        ull swap = -((exp >> bit) & 1);
+        for (int k = 0; k < w; k++) {
+            ull x = ct_select(swap, r1[k], r0[k]);
+            ull y = ct_select(swap, r0[k], r1[k]);
+            y = mont_mul(ctx, x, y);
+            x = mont_mul(ctx, x, x);
+            r0[k] = ct_select(swap, y, x);
+            r1[k] = ct_select(swap, x, y);
+        }
+    }
+    for (int k = 0; k < w; k++) out[k] = mont_from(ctx, r0[k]);
+}
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+// SIMD-ядро для непарних модулів n < 2^32 (половинки p та q у CRT):
+// чотири 64-бітні лани AVX2, множення 32x32->64 через _mm256_mul_epu32,
+// Монтгомері з R = 2^32. Для 63-бітного n в AVX2 немає множення 64x64,
+// тому модуль сітки лишається на скалярних ядрах.
+// Викликати лише після __builtin_cpu_supports("avx2").
+#define SIMD_LANES 4
+
+__attribute__((target("avx2")))
+static inline __m256i mont32_mul_avx2(__m256i a, __m256i b, __m256i n, __m256i ninv) {
+    const __m256i low32 = _mm256_set1_epi64x(0xffffffffLL);
+    __m256i t = _mm256_mul_epu32(a, b);
+    __m256i m = _mm256_mul_epu32(t, ninv);
+    __m256i mn = _mm256_mul_epu32(m, n);
+    // lo32(t) + lo32(mn) == 0 mod 2^32: перенос є, коли lo32(t) != 0
+    __m256i zero_lo = _mm256_cmpeq_epi64(_mm256_and_si256(t, low32), _mm256_setzero_si256());
+    __m256i u = _mm256_add_epi64(_mm256_srli_epi64(t, 32), _mm256_srli_epi64(mn, 32));
+    u = _mm256_add_epi64(u, _mm256_add_epi64(_mm256_set1_epi64x(1), zero_lo));
+    __m256i below = _mm256_cmpgt_epi64(n, u);
+    return _mm256_blendv_epi8(_mm256_sub_epi64(u, n), u, below);
+}
+
+__attribute__((target("avx2")))
+static inline void modexp32_avx2(const ull *base, ull *out, ull exp, ull mod) {
+    ull inv = mod;
+    for (int i = 0; i < 4; i++) inv *= 2 - mod * inv;
+    ull r1 = (1ULL << 32) % mod;
+    ull r2 = (r1 * r1) % mod;
+
+    __m256i n = _mm256_set1_epi64x((ll) mod);
+    __m256i ninv = _mm256_set1_epi64x((ll) ((0 - inv) & 0xffffffffULL));
+    __m256i b = _mm256_set_epi64x((ll) (base[3] % mod), (ll) (base[2] % mod),
+                                  (ll) (base[1] % mod), (ll) (base[0] % mod));
+    b = mont32_mul_avx2(b, _mm256_set1_epi64x((ll) r2), n, ninv);
+    __m256i result = _mm256_set1_epi64x((ll) r1);
+    while (exp > 0) {
+        if (exp & 1) result = mont32_mul_avx2(result, b, n, ninv);
+        exp >>= 1;
+        b = mont32_mul_avx2(b, b, n, ninv);
+    }
+    result = mont32_mul_avx2(result, _mm256_set1_epi64x(1), n, ninv);
+    _mm256_storeu_si256((__m256i *) out, result);
+}
+#endif
+
+// Викликає *_ilp зі сталою шириною для типових 4 та 8, щоб цикли по
+// ланцюжках повністю розгорталися, і з довільною шириною для хвоста рядка.
+#define ILP_CALL(fn, w, ...)                    \
+    do {                                        \
+        if ((w) == 8) fn(__VA_ARGS__, 8);       \
+        else if ((w) == 4) fn(__VA_ARGS__, 4);  \
+        else fn(__VA_ARGS__, (w));              \
+    } while (0)
+
+// Кілька експонент для тих самих повідомлень (--exponents). Ланцюжок
+// квадратів base^(2^s) спільний, а кожна експонента лише домножує свій
+// результат на ті квадрати, де в неї біт 1 — у тому ж порядку, що й одиночне
+// ядро, тож результати збігаються біт у біт (для legacy — разом з
+// переповненням). Як і в *_ilp, ланцюжки `w` повідомлень чергуються, бо
+// квадрати одного повідомлення залежать один від одного. Результат
+// експоненти k для повідомлення m — out[k * w + m].
+#define MULTI_EXP_MAX 16
+
+// OR усіх експонент: скільки квадратів потрібно спільному ланцюжку
+static inline ull multi_exp_bits(const ull *exps, int count) {
+    ull bits = 0;
+    for (int k = 0; k < count; k++) bits |= exps[k];
+    return bits;
+}
+
+static inline __attribute__((always_inline))
+void modexp_multi(const ull *base, ull *out, const ull *exps, int count, ull mod, int w) {
+    ull result[MULTI_EXP_MAX * ILP_MAX], b[ILP_MAX];
+    for (int k = 0; k < count * w; k++) result[k] = 1;
+    for (int m = 0; m < w; m++) b[m] = base[m] % mod;
+    int s = 0;
+    for (ull bits = multi_exp_bits(exps, count); bits; bits >>= 1, s++) {
+        for (int k = 0; k < count; k++)
+            if ((exps[k] >> s) & 1)
+                for (int m = 0; m < w; m++) result[k * w + m] = (result[k * w + m] * b[m]) % mod;
+        for (int m = 0; m < w; m++) b[m] = (b[m] * b[m]) % mod;
+    }
+    for (int k = 0; k < count * w; k++) out[k] = result[k];
+}
+
+static inline __attribute__((always_inline))
+void modexp_u128_multi(const ull *base, ull *out, const ull *exps, int count, ull mod, int w) {
+    ull result[MULTI_EXP_MAX * ILP_MAX], b[ILP_MAX];
+    for (int k = 0; k < count * w; k++) result[k] = 1;
+    for (int m = 0; m < w; m++) b[m] = base[m] % mod;
+    int s = 0;
+    for (ull bits = multi_exp_bits(exps, count); bits; bits >>= 1, s++) {
+        for (int k = 0; k < count; k++)
+            if ((exps[k] >> s) & 1)
+                for (int m = 0; m < w; m++) result[k * w + m] = mulmod_u128(result[k * w + m], b[m], mod);
+        for (int m = 0; m < w; m++) b[m] = mulmod_u128(b[m], b[m], mod);
+    }
+    for (int k = 0; k < count * w; k++) out[k] = result[k];
+}
+
+static inline __attribute__((always_inline))
+void modexp_barrett_multi(const barrett_ctx *ctx, const ull *base, ull *out, const ull *exps, int count, int w) {
+    ull result[MULTI_EXP_MAX * ILP_MAX], b[ILP_MAX];
+    for (int k = 0; k < count * w; k++) result[k] = 1 % ctx->n;
+    for (int m = 0; m < w; m++) b[m] = base[m] % ctx->n;
+    int s = 0;
+    for (ull bits = multi_exp_bits(exps, count); bits; bits >>= 1, s++) {
+        for (int k = 0; k < count; k++)
+            if ((exps[k] >> s) & 1)
+                for (int m = 0; m < w; m++)
+                    result[k * w + m] = mulmod_barrett(ctx, result[k * w + m], b[m]);
+        for (int m = 0; m < w; m++) b[m] = mulmod_barrett(ctx, b[m], b[m]);
+    }
+    for (int k = 0; k < count * w; k++) out[k] = result[k];
+}
+
+// Перетворення у форму Монтгомері — одне на повідомлення, назад — одне на
+// пару повідомлення й експоненти
+static inline __attribute__((always_inline))
+void modexp_mont_multi(const mont_ctx *ctx, const ull *base, ull *out, const ull *exps, int count, int w) {
+    ull result[MULTI_EXP_MAX * ILP_MAX], b[ILP_MAX];
+    for (int k = 0; k < count * w; k++) result[k] = ctx->r1;
+    for (int m = 0; m < w; m++) b[m] = mont_to(ctx, base[m]);
+    int s = 0;
+    for (ull bits = multi_exp_bits(exps, count); bits; bits >>= 1, s++) {
+        for (int k = 0; k < count; k++)
+            if ((exps[k] >> s) & 1)
+                for (int m = 0; m < w; m++) result[k * w + m] = mont_mul(ctx, result[k * w + m], b[m]);
+        for (int m = 0; m < w; m++) b[m] = mont_mul(ctx, b[m], b[m]);
+    }
+    for (int k = 0; k < count * w; k++) out[k] = mont_from(ctx, result[k]);
+}
+
+#endif
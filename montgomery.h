@@ -0,0 +1,113 @@
+#ifndef MONTGOMERY_H
+#define MONTGOMERY_H
+
+typedef unsigned long long ull;
+
+// Арифметика Монтгомері за непарним модулем n < 2^63 з R = 2^64.
+// Множення не має ні ділення, ні розгалужень, що залежать від даних,
+// тому на ньому будується сталочасове піднесення до степеня.
+typedef struct {
+    ull n;
+    ull ninv;   // -n^-1 mod 2^64
+    ull r1;     // R mod n, одиниця у формі Монтгомері
+    ull r2;     // R^2 mod n, для переведення у форму Монтгомері
+} mont_ctx;
+
+// Повертає 0 або -1, якщо n парне чи не менше 2^63
+static inline int mont_init(mont_ctx *ctx, ull n) {
+    if ((n & 1) == 0 || n >= (1ULL << 63)) return -1;
+    ull inv = n;                    // n * n == 1 mod 8, далі — ітерації Ньютона
+    for (int i = 0; i < 5; i++) inv *= 2 - n * inv;
+    ctx->n = n;
+    ctx->ninv = -inv;
+    ctx->r1 = (ull) (((unsigned __int128) 1 << 64) % n);
+    ctx->r2 = (ull) (((unsigned __int128) ctx->r1 * ctx->r1) % n);
+    return 0;
+}
+
+// Сталочасовий вибір: mask — усі нулі або всі одиниці
+static inline ull ct_select(ull mask, ull a, ull b) {
+    return (a & mask) | (b & ~mask);
+}
+
+// a * b * R^-1 mod n для a, b < n
+static inline ull mont_mul(const mont_ctx *ctx, ull a, ull b) {
+    unsigned __int128 t = (unsigned __int128) a * b;
+    ull t_lo = (ull) t;
+    ull m = t_lo * ctx->ninv;
+    unsigned __int128 mn = (unsigned __int128) m * ctx->n;
+    // t_lo + lo(mn) == 0 mod 2^64, перенос є тоді й лише тоді, коли t_lo != 0
+    ull u = (ull) (t >> 64) + (ull) (mn >> 64) + (t_lo != 0);
+    ull reduced = u - ctx->n;
+    ull keep = -(ull) (u < ctx->n);
+    return ct_select(keep, u, reduced);
+}
+
+static inline ull mont_to(const mont_ctx *ctx, ull a) {
+    return mont_mul(ctx, a % ctx->n, ctx->r2);
+}
+
+static inline ull mont_from(const mont_ctx *ctx, ull a) {
+    return mont_mul(ctx, a, 1);
+}
+
+// Сходинки Монтгомері: завжди `bits` кроків з одним множенням і одним
+// піднесенням до квадрата, біти експоненти впливають лише на маску обміну.
+// `bits` — публічна довжина експоненти (64 або розмір модуля для CRT).
+static inline ull modexp_ladder(const mont_ctx *ctx, ull base, ull exp, int bits) {
+    ull r0 = ctx->r1;
+    ull r1 = mont_to(ctx, base);
+    for (int bit = bits - 1; bit >= 0; bit--) {
+        ull swap = -((exp >> bit) & 1);
+        ull x = ct_select(swap, r1, r0);
+        ull y = ct_select(swap, r0, r1);
+        y = mont_mul(ctx, x, y);
+        x = mont_mul(ctx, x, x);
+        r0 = ct_select(swap, y, x);
+        r1 = ct_select(swap, x, y);
+    }
+    return mont_from(ctx, r0);
+}
+
+// Те саме з R = 2^32 для модулів n < 2^32 (p та q у CRT): добуток
+// вміщується в 64 біти, тож множення — три звичайні imul замість
+// 128-бітних mul. Значення — ull, щоб не змішувати типи в ланцюжках.
+typedef struct {
+    ull n;
+    ull ninv;   // -n^-1 mod 2^32
+    ull r1;     // 2^32 mod n
+    ull r2;     // 2^64 mod n
+} mont32_ctx;
+
+// Повертає 0 або -1, якщо n парне чи не менше 2^32
+static inline int mont32_init(mont32_ctx *ctx, ull n) {
+    if ((n & 1) == 0 || n >= (1ULL << 32)) return -1;
+    ull inv = n;
+    for (int i = 0; i < 4; i++) inv *= 2 - n * inv;
+    ctx->n = n;
+    ctx->ninv = (0 - inv) & 0xffffffffULL;
+    ctx->r1 = (1ULL << 32) % n;
+    ctx->r2 = (ctx->r1 * ctx->r1) % n;
+    return 0;
+}
+
+// a * b * 2^-32 mod n для a, b < n, без розгалужень
+static inline ull mont32_mul(const mont32_ctx *ctx, ull a, ull b) {
+    ull t = a * b;
+    ull m = ((t & 0xffffffffULL) * ctx->ninv) & 0xffffffffULL;
+    ull mn = m * ctx->n;
+    // lo32(t) + lo32(mn) == 0 mod 2^32, перенос є тоді й лише тоді, коли lo32(t) != 0
+    ull u = (t >> 32) + (mn >> 32) + ((t & 0xffffffffULL) != 0);
+    ull keep = -(ull) (u < ctx->n);
+    return ct_select(keep, u, u - ctx->n);
+}
+
+static inline ull mont32_to(const mont32_ctx *ctx, ull a) {
+    return mont32_mul(ctx, a % ctx->n, ctx->r2);
+}
+
+static inline ull mont32_from(const mont32_ctx *ctx, ull a) {
+    return mont32_mul(ctx, a, 1);
+}
+
+#endif
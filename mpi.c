@@ -1,45 +1,352 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <mpi.h>
 #include <limits.h>
 #include <tgmath.h>
+#include "rsa.h"
+#include "options.h"
+#include "report.h"
+#include "progress.h"
+#include "trace.h"
+#include "timing.h"
+#include "perf_counters.h"
+#include "gridfile.h"
 
 #define WIDTH  3000
 #define HEIGHT 3000
 
-typedef unsigned long long ull;
-typedef long long ll;
-
 // RSA константи
 const ll p_const = 3000000007LL;
 const ll q_const = 3000000011LL;
 const ll n_const = p_const * q_const;
 const ll e_const = 900000000000000LL;
 
-// Функція швидкого піднесення до степеня за модулем
-ull modexp(ull base, ull exp, ull mod) {
-    ull result = 1;
-    base %= mod;
-    while (exp > 0) {
-        if (exp & 1) result = (result * base) % mod;
-        exp >>= 1;
-        base = (base * base) % mod;
+#define PROGRESS_TAG 33
+#define CLOCK_TAG 34
+#define CLOCK_SYNC_ROUNDS 8
+
+// Розбіжність перевірки, відкладена до узгодження ліміту звіту між процесами
+typedef struct {
+    int row, col;
+    ull message, ciphertext, decrypted;
+} verify_mismatch;
+
+// Збір прогресу для --progress. Потік монітора кожного не-root процесу
+// надсилає rank 0 свій лічильник рядків через MPI_Isend (нове — лише коли
+// попереднє вже доставлене), монітор rank 0 забирає все, що прийшло, через
+// MPI_Iprobe. Основний потік під час обчислення MPI не викликає, тож
+// достатньо MPI_THREAD_SERIALIZED.
+typedef struct {
+    MPI_Comm comm;
+    int rank;
+    MPI_Request request;
+    long long msg[2];       // рядків готово, чи це останнє повідомлення
+    int *done;              // rank 0: хто вже надіслав останнє
+    int remaining;
+} mpi_progress;
+
+static void mpi_progress_hook(progress_monitor *mon, int final) {
+    mpi_progress *mp = mon->hook_ctx;
+    if (mp->rank != 0) {
+        int sent = 1;
+        if (mp->request != MPI_REQUEST_NULL) {
+            if (final) MPI_Wait(&mp->request, MPI_STATUS_IGNORE);
+            else MPI_Test(&mp->request, &sent, MPI_STATUS_IGNORE);
+        }
+        if (!sent) return;
+        mp->msg[0] = atomic_load_explicit(&mon->slots[0].rows, memory_order_relaxed);
+        mp->msg[1] = final;
+        if (final) MPI_Send(mp->msg, 2, MPI_LONG_LONG, 0, PROGRESS_TAG, mp->comm);
+        else MPI_Isend(mp->msg, 2, MPI_LONG_LONG, 0, PROGRESS_TAG, mp->comm, &mp->request);
+        return;
+    }
+
+    // На rank 0 останній виклик чекає останніх повідомлень від усіх процесів
+    for (;;) {
+        int flag = 0;
+        MPI_Status status;
+        if (final && mp->remaining > 0) {
+            MPI_Probe(MPI_ANY_SOURCE, PROGRESS_TAG, mp->comm, &status);
+            flag = 1;
+        } else {
+            MPI_Iprobe(MPI_ANY_SOURCE, PROGRESS_TAG, mp->comm, &flag, &status);
+        }
+        if (!flag) break;
+        long long msg[2];
+        MPI_Recv(msg, 2, MPI_LONG_LONG, status.MPI_SOURCE, PROGRESS_TAG, mp->comm, MPI_STATUS_IGNORE);
+        atomic_store_explicit(&mon->slots[status.MPI_SOURCE].rows, msg[0], memory_order_relaxed);
+        if (msg[1] && !mp->done[status.MPI_SOURCE]) {
+            mp->done[status.MPI_SOURCE] = 1;
+            mp->remaining--;
+        }
+    }
+}
+
+// Зсув CLOCK_MONOTONIC кожного процесу відносно rank 0. Rank 0 надсилає
+// запит і отримує у відповідь час процесу; з кількох обмінів береться той,
+// що має найменший час обігу, а зсув рахується від його середини.
+static long long trace_clock_offset(int rank, int size) {
+    long long offset = 0;
+    for (int p = 1; p < size; p++) {
+        if (rank == 0) {
+            long long best_rtt = LLONG_MAX;
+            for (int k = 0; k < CLOCK_SYNC_ROUNDS; k++) {
+                long long t0 = trace_now(), remote;
+                MPI_Send(&t0, 1, MPI_LONG_LONG, p, CLOCK_TAG, MPI_COMM_WORLD);
+                MPI_Recv(&remote, 1, MPI_LONG_LONG, p, CLOCK_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                long long t1 = trace_now();
+                if (t1 - t0 < best_rtt) {
+                    best_rtt = t1 - t0;
+                    offset = remote - (t0 + (t1 - t0) / 2);
+                }
+            }
+            MPI_Send(&offset, 1, MPI_LONG_LONG, p, CLOCK_TAG, MPI_COMM_WORLD);
+        } else if (rank == p) {
+            for (int k = 0; k < CLOCK_SYNC_ROUNDS; k++) {
+                long long request, now;
+                MPI_Recv(&request, 1, MPI_LONG_LONG, 0, CLOCK_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                now = trace_now();
+                MPI_Send(&now, 1, MPI_LONG_LONG, 0, CLOCK_TAG, MPI_COMM_WORLD);
+            }
+            MPI_Recv(&offset, 1, MPI_LONG_LONG, 0, CLOCK_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+    }
+    return rank == 0 ? 0 : offset;
+}
+
+// Збирає події всіх процесів на rank 0 у годиннику rank 0 і пише файл.
+// Колективна операція; повертає 0 або -1 (на всіх процесах, якщо збір не
+// вдався, інакше — помилка запису на rank 0).
+static int trace_gather_write(trace_log *trace, const char *path, int rank, int size) {
+    long long offset = trace_clock_offset(rank, size);
+    size_t count;
+    long long dropped;
+    trace_event *events = trace_collect(trace, offset, &count, &dropped);
+    if (dropped)
+        fprintf(stderr, "Процес %d: трасування перезаписало %lld найстаріших подій\n", rank, dropped);
+
+    // Події йдуть як один тип MPI, тож лічильники й зміщення Gatherv —
+    // у подіях, а не в байтах; їхня сума все одно мусить влізти в int
+    long long local_count = (long long) count;
+    long long *counts64 = NULL;
+    int *counts = NULL, *displs = NULL;
+    trace_event *all = NULL;
+    size_t total = 0;
+    int ok = 1;
+    if (rank == 0) {
+        counts64 = malloc(size * sizeof(long long));
+        counts = malloc(size * sizeof(int));
+        displs = malloc(size * sizeof(int));
+        ok = counts64 && counts && displs;
+        if (!ok) fprintf(stderr, "Помилка виділення буфера трасування!\n");
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    int counted = ok;
+    if (counted) MPI_Gather(&local_count, 1, MPI_LONG_LONG, counts64, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (ok && rank == 0) {
+        long long sum = 0;
+        for (int p = 0; p < size; p++) {
+            if (counts64[p] > INT_MAX - sum) {
+                fprintf(stderr, "Трасування: разом понад %d подій, файл не записано\n", INT_MAX);
+                ok = 0;
+                break;
+            }
+            counts[p] = (int) counts64[p];
+            displs[p] = (int) sum;
+            sum += counts64[p];
+        }
+        total = (size_t) sum;
+        if (ok) all = malloc((total ? total : 1) * sizeof(trace_event));
+        if (ok && !all) {
+            fprintf(stderr, "Помилка виділення буфера трасування!\n");
+            ok = 0;
+        }
+    }
+    if (counted) MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (ok) {
+        MPI_Datatype event_type;
+        MPI_Type_contiguous((int) sizeof(trace_event), MPI_BYTE, &event_type);
+        MPI_Type_commit(&event_type);
+        MPI_Gatherv(events, (int) count, event_type, all, counts, displs, event_type, 0, MPI_COMM_WORLD);
+        MPI_Type_free(&event_type);
+    }
+
+    int rc = ok ? 0 : -1;
+    if (ok && rank == 0) rc = trace_write(path, "mpi", all, total);
+    free(events);
+    free(all);
+    free(counts64);
+    free(counts);
+    free(displs);
+    trace_free(trace);
+    return rc;
+}
+
+// Лічильники всіх процесів на rank 0: значення подій і кількість клітинок
+static void perf_gather_report(const perf_counters *pc, int rank, int size) {
+    long long local[PERF_EVENTS + 1];
+    memcpy(local, pc->value, sizeof(pc->value));
+    local[PERF_EVENTS] = pc->cells;
+    long long *all = NULL;
+    if (rank == 0) all = malloc((size_t) size * (PERF_EVENTS + 1) * sizeof(long long));
+    MPI_Gather(local, PERF_EVENTS + 1, MPI_LONG_LONG, all, PERF_EVENTS + 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (rank != 0) return;
+
+    perf_counters *pcs = aligned_alloc(CACHE_LINE, size * sizeof(perf_counters));
+    for (int p = 0; p < size; p++) {
+        perf_clear(&pcs[p]);
+        memcpy(pcs[p].value, &all[p * (PERF_EVENTS + 1)], sizeof(pcs[p].value));
+        pcs[p].cells = all[p * (PERF_EVENTS + 1) + PERF_EVENTS];
+    }
+    perf_report(pcs, size, "Процес");
+    free(pcs);
+    free(all);
+}
+
+// Енергія кожного вузла за весь запуск: перший процес вузла шле свою суму, решта — -1
+static void node_energy_report(const phase_timer *phases, int rank, int size) {
+    char name[MPI_MAX_PROCESSOR_NAME] = {0};
+    int len;
+    MPI_Get_processor_name(name, &len);
+    double local = phases->has_energy ? phase_total_joules(phases) : -1.0;
+    double *all = rank == 0 ? malloc(size * sizeof(double)) : NULL;
+    char *names = rank == 0 ? malloc((size_t) size * MPI_MAX_PROCESSOR_NAME) : NULL;
+    MPI_Gather(&local, 1, MPI_DOUBLE, all, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Gather(name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, names, MPI_MAX_PROCESSOR_NAME, MPI_CHAR,
+               0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        for (int p = 0; p < size; p++)
+            if (all[p] >= 0.0)
+                printf("Вузол %s (процес %d): %.3f Дж\n", &names[(size_t) p * MPI_MAX_PROCESSOR_NAME], p, all[p]);
+        free(all);
+        free(names);
+    }
+}
+
+// Вибірка --preview: усі процеси генерують ті самі клітинки, кожен шифрує
+// свою неперервну частину, і результати збираються в усіх через MPI_Allgatherv
+typedef struct {
+    const modexp_plan *plan;
+    int rank, size;
+    int *counts, *displs;
+} preview_ctx;
+
+static void preview_encrypt(void *ctx, const ull *messages, ull *out, long count) {
+    preview_ctx *p = ctx;
+    for (int r = 0; r < p->size; r++) {
+        p->displs[r] = (int)(count * r / p->size);
+        p->counts[r] = (int)(count * (r + 1) / p->size) - p->displs[r];
     }
-    return result;
+    plan_encrypt_messages(p->plan, messages + p->displs[p->rank], out + p->displs[p->rank],
+                          p->counts[p->rank]);
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, out, p->counts, p->displs,
+                   MPI_UNSIGNED_LONG_LONG, MPI_COMM_WORLD);
+}
+
+// Бюджет часу міряє кожен процес сам, зупинку вирішує процес 0
+static int preview_agree(void *ctx, int stop) {
+    (void) ctx;
+    MPI_Bcast(&stop, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return stop;
+}
+
+// Режим --extend: кожен процес відображає збережений файл і рахує свою
+// смугу з EXTEND_BLOCK_ROWS рядків блоку, rank 0 збирає блок і дописує його
+#define EXTEND_BLOCK_ROWS 64
+
+static int run_extend(const grid_options *opts, const modexp_plan *plan, int width, int height,
+                      int rank, int size) {
+    gridfile_map old;
+    grid_extension x;
+    gridfile_writer w;
+    ull min = ULLONG_MAX, max = 0;
+    int opened = gridfile_open(&old, opts->extend) == 0;
+    int ok = opened && grid_extension_init(&x, plan, &old, width, height) == 0 &&
+             grid_extension_begin(&x, rank == 0 ? &w : NULL, opts->output ? opts->output : opts->extend,
+                                  &min, &max) == 0;
+    int block_rows = size * EXTEND_BLOCK_ROWS;
+    ull *block = ok ? malloc((size_t)(rank == 0 ? block_rows : EXTEND_BLOCK_ROWS) * width * sizeof(ull)) : NULL;
+    int *counts = ok ? malloc(2 * size * sizeof(int)) : NULL;
+    if (ok && (!block || !counts)) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        if (rank == 0) gridfile_abort(&w);
+        ok = 0;
+    }
+    int all_ok;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    if (!all_ok) {
+        if (ok && rank == 0) gridfile_abort(&w);
+        free(block);
+        free(counts);
+        if (opened) gridfile_close(&old);
+        return 1;
+    }
+    int *displs = counts + size;
+
+    double t0 = wall_now();
+    long long computed = 0;
+    for (int first = 0; first < height && ok; first += block_rows) {
+        int rows = height - first < block_rows ? height - first : block_rows;
+        for (int r = 0; r < size; r++) {
+            int begin = r * EXTEND_BLOCK_ROWS < rows ? r * EXTEND_BLOCK_ROWS : rows;
+            int end = begin + EXTEND_BLOCK_ROWS < rows ? begin + EXTEND_BLOCK_ROWS : rows;
+            displs[r] = begin * width;
+            counts[r] = (end - begin) * width;
+        }
+        int mine = counts[rank] / width, own = displs[rank] / width;
+        for (int r = 0; r < mine; r++)
+            computed += grid_extension_row(&x, first + own + r, &block[(size_t)r * width], &min, &max);
+        // rank 0 приймає блок на місце, де вже лежать його власні рядки
+        MPI_Gatherv(rank == 0 ? MPI_IN_PLACE : block, counts[rank], MPI_UNSIGNED_LONG_LONG,
+                    block, counts, displs, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+        if (rank == 0 && gridfile_write_rows(&w, block, rows) != 0) ok = 0;
+        MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+
+    ull global_min, global_max;
+    long long global_computed;
+    MPI_Reduce(&min, &global_min, 1, MPI_UNSIGNED_LONG_LONG, MPI_MIN, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&max, &global_max, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&computed, &global_computed, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    double elapsed = wall_now() - t0;
+
+    int rc = ok ? 0 : 1;
+    if (rank == 0) {
+        if (!ok) {
+            gridfile_abort(&w);
+        } else {
+            grid_summary summary = {"mpi", size, width, height, grid_kernel_name(plan->kernel), plan->ilp,
+                                    plan->e, x.col_step, elapsed, global_min, global_max, {0}};
+            rc = grid_extension_finish(&x, &w, opts, &summary, global_computed, global_min, global_max);
+        }
+    }
+    MPI_Bcast(&rc, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    free(block);
+    free(counts);
+    gridfile_close(&old);
+    return rc;
 }
 
 int main(int argc, char *argv[]) {
-    MPI_Init(&argc, &argv);
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    grid_options opts;
+    if (parse_options(argc, argv, &opts) != 0) {
+        MPI_Finalize();
+        return 1;
+    }
+
     int width, height;
     ull n;
     ll e;
     if (rank == 0) {
-        width = WIDTH;
-        height = HEIGHT;
+        width = opts.width ? opts.width : WIDTH;
+        height = opts.height ? opts.height : HEIGHT;
         n = n_const;
         e = e_const;
     }
@@ -49,8 +356,57 @@ int main(int argc, char *argv[]) {
     MPI_Bcast(&n, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
     MPI_Bcast(&e, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
 
-    int rows_per_proc = HEIGHT / size;
-    int remainder = HEIGHT % size;
+    rsa_key key;
+    modexp_plan plan;
+    if (options_setup(&opts, n, e, &key, &plan) != 0) {
+        MPI_Finalize();
+        return 1;
+    }
+    // Процеси збирають сітку смугами рядків через MPI_Gatherv
+    if (opts.layout != LAYOUT_ROW || opts.exponent_count) {
+        if (rank == 0) fprintf(stderr, "mpi підтримує лише --layout=row і одну експоненту\n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (opts.extend) {
+        int rc = run_extend(&opts, &plan, width, height, rank, size);
+        MPI_Finalize();
+        return rc;
+    }
+
+    phase_timer phases;
+    phase_init(&phases);
+    // Лічильники RAPL спільні для процесів одного вузла, тож міряє лише перший з них
+    MPI_Comm node_comm = MPI_COMM_NULL;
+    energy_meter energy;
+    if (opts.energy) {
+        int node_rank;
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+        MPI_Comm_rank(node_comm, &node_rank);
+        if (node_rank == 0) {
+            if (energy_open(&energy, ENERGY_SYSFS) == 0) phase_attach_energy(&phases, &energy);
+            else fprintf(stderr, "Процес %d: " ENERGY_UNAVAILABLE_MSG, rank);
+        }
+    }
+
+    // Повідомлення клітинки (i, j) — i * width + j * col_step, за замовчуванням (i + j) * width
+    ull col_step = grid_col_step(&opts, FORMULA_DIAG, width);
+
+    if (opts.preview > 0.0) {
+        preview_config cfg = {width, height, col_step, plan.n, opts.preview, opts.preview_eps, PREVIEW_SEED};
+        int *counts = malloc(2 * size * sizeof(int));
+        preview_ctx ctx = {&plan, rank, size, counts, counts ? counts + size : NULL};
+        preview_result res;
+        int rc = counts && preview_run(&cfg, preview_encrypt, preview_agree, &ctx, &res) == 0 ? 0 : 1;
+        if (rc == 0 && rank == 0) preview_report(&cfg, &res, "mpi", size, opts.summary);
+        free(counts);
+        MPI_Finalize();
+        return rc;
+    }
+
+    int rows_per_proc = height / size;
+    int remainder = height % size;
     int start_row = (rank < remainder)
                         ? rank * (rows_per_proc + 1)
                         : rank * rows_per_proc + remainder;
@@ -63,68 +419,252 @@ int main(int argc, char *argv[]) {
 
     ull local_min = ULLONG_MAX;
     ull local_max = 0;
-    double start_time = MPI_Wtime();
+    grid_fingerprint local_fp = {0, 0};
+
+    // rank 0 веде лічильник на кожен процес, решта — лише власний
+    progress_monitor progress;
+    mpi_progress mp = {MPI_COMM_NULL, rank, MPI_REQUEST_NULL, {0, 0}, NULL, size - 1};
+    if (progress_init(&progress, "mpi", rank == 0 ? size : 1, rank == 0 ? height : local_rows,
+                      width, opts.progress, opts.progress_file) != 0) {
+        fprintf(stderr, "Помилка виділення лічильників прогресу!\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (opts.progress > 0.0) {
+        if (provided >= MPI_THREAD_SERIALIZED && size > 1) {
+            MPI_Comm_dup(MPI_COMM_WORLD, &mp.comm);
+            mp.done = calloc(size, sizeof(int));
+            if (rank == 0 && !mp.done) {
+                fprintf(stderr, "Помилка виділення лічильників прогресу!\n");
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            progress.hook = mpi_progress_hook;
+            progress.hook_ctx = &mp;
+        } else if (rank == 0 && size > 1) {
+            fprintf(stderr, "MPI без MPI_THREAD_SERIALIZED: прогрес лише rank 0\n");
+        }
+        progress.emit = rank == 0;
+        if ((rank == 0 || progress.hook) && progress_start(&progress) != 0)
+            fprintf(stderr, "Не вдалося запустити потік прогресу процесу %d\n", rank);
+    }
 
-    ull *local_data = malloc(local_rows * WIDTH * sizeof(ull));
+    trace_log trace;
+    if (trace_init(&trace, opts.trace != NULL, 1, rank) != 0) {
+        fprintf(stderr, "Помилка виділення буфера трасування!\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    trace_ring *ring = trace_thread(&trace, 0);
+
+    grid_buffer local_buf;
+    ull *local_data = grid_buffer_alloc(&local_buf, (size_t) local_rows * width, opts.pages);
+    if (!local_data) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    perf_counters perf;
+    perf_clear(&perf);
+    if (opts.perf && perf_open(&perf) == 0)
+        fprintf(stderr, "Процес %d: " PERF_UNAVAILABLE_MSG, rank);
+    phase_mark(&phases, PHASE_ALLOC);
+
+    if (opts.perf) perf_begin(&perf);
+
+    long long row_begin = ring ? trace_now() : 0;
     for (int i = 0; i < local_rows; i++) {
         int global_row = start_row + i;
         if (global_row == 500) {
             printf("Процес %d: обробка глобального рядка %d\n", rank, global_row);
         }
-        for (int j = 0; j < WIDTH; j++) {
-            ll message = (global_row + j) * WIDTH;
-            ull ciphertext = modexp((ull) message, e, n);
-
-            local_data[i * WIDTH + j] = ciphertext;
-            if (ciphertext < local_min) local_min = ciphertext;
-            if (ciphertext > local_max) local_max = ciphertext;
+        ull *row = &local_data[(size_t) i * width];
+        plan_encrypt_row(&plan, (ull) global_row * width, col_step, row, width,
+                         &local_min, &local_max);
+        if (opts.checksum)
+            fingerprint_add(&local_fp, fingerprint_row((ull) global_row * width, row, width));
+        progress_row_done(&progress.slots[0]);
+        if (ring) {
+            long long row_end = trace_now();
+            trace_record(ring, TRACE_ROWS, row_begin, row_end, global_row, 1);
+            row_begin = row_end;
         }
     }
 
+    if (opts.perf) perf_end(&perf, (long long) local_rows * width);
+    // Потік прогресу сам викликає MPI, а з MPI_THREAD_SERIALIZED виклики не
+    // можуть перетинатися, тож він зупиняється до бар'єра вузла
+    if (opts.progress > 0.0 && (rank == 0 || progress.hook)) progress_stop(&progress);
+    if (mp.comm != MPI_COMM_NULL) MPI_Comm_free(&mp.comm);
+    free(mp.done);
+    progress_free(&progress);
+    // Процеси вузла закривають обчислення разом, щоб енергія всього вузла лягла у фазу compute
+    if (opts.energy) MPI_Barrier(node_comm);
+    phase_mark(&phases, PHASE_COMPUTE);
+
     ull global_min, global_max;
     double global_time;
+    long long reduce_begin = ring ? trace_now() : 0;
     MPI_Reduce(&local_min, &global_min, 1, MPI_UNSIGNED_LONG_LONG, MPI_MIN, 0, MPI_COMM_WORLD);
     MPI_Reduce(&local_max, &global_max, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
 
-    double end_time = MPI_Wtime();
-    double local_time = end_time - start_time;
+    // Відбиток об'єднується сумою двох лан, без збору сітки
+    grid_fingerprint global_fp = {0, 0};
+    if (opts.checksum)
+        MPI_Reduce(&local_fp, &global_fp, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    // Час сітки — обчислення разом з редукцією, як і в openmp.c
+    phase_mark(&phases, PHASE_REDUCE);
+    double local_time = phases.seconds[PHASE_COMPUTE] + phases.seconds[PHASE_REDUCE];
     MPI_Reduce(&local_time, &global_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (ring) trace_record(ring, TRACE_REDUCE, reduce_begin, trace_now(), 0, 0);
+    phase_mark(&phases, PHASE_REDUCE);
+
+    // Кожен процес перевіряє власні рядки, до збору сітки на rank 0
+    ll global_mismatches = 0;
+    double verify_time = 0.0;
+    if (opts.verify) {
+        ll local_mismatches = 0;
+        long long verify_begin = ring ? trace_now() : 0;
+        ull decrypted[ILP_MAX];
+        verify_mismatch noted[VERIFY_REPORT_LIMIT];
+        for (int i = 0; i < local_rows; i++) {
+            int global_row = start_row + i;
+            for (int j = 0; j < width; j += plan.ilp) {
+                int count = width - j < plan.ilp ? width - j : plan.ilp;
+                const ull *ciphertexts = &local_data[(size_t) i * width + j];
+                plan_decrypt_batch(&plan, &key, ciphertexts, decrypted, count);
+                for (int k = 0; k < count; k++) {
+                    ull message = (ull) global_row * width + (j + k) * col_step;
+                    if (decrypted[k] != message) {
+                        if (local_mismatches < VERIFY_REPORT_LIMIT)
+                            noted[local_mismatches] = (verify_mismatch) {global_row, j + k, message,
+                                                                          ciphertexts[k], decrypted[k]};
+                        local_mismatches++;
+                    }
+                }
+            }
+        }
+        // Ліміт звіту — на весь запуск: процес друкує лише ту частину своїх
+        // розбіжностей, що не вичерпана процесами з меншим rank
+        ll before = 0;
+        MPI_Exscan(&local_mismatches, &before, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        if (rank == 0) before = 0;
+        for (ll m = 0; m < local_mismatches && m < VERIFY_REPORT_LIMIT && before + m < VERIFY_REPORT_LIMIT; m++)
+            rsa_report_mismatch(noted[m].row, noted[m].col, noted[m].message,
+                                noted[m].ciphertext, noted[m].decrypted);
+        double local_verify = phase_mark(&phases, PHASE_VERIFY);
+        if (ring) trace_record(ring, TRACE_VERIFY, verify_begin, trace_now(), local_mismatches, 0);
+        MPI_Reduce(&local_mismatches, &global_mismatches, 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        MPI_Reduce(&local_verify, &verify_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        phase_mark(&phases, PHASE_REDUCE);
+    }
 
     int *recvcounts = NULL, *displs = NULL;
     ull *global_data = NULL;
+    grid_buffer global_buf = {NULL, 0, PAGES_DEFAULT};
     if (rank == 0) {
-        global_data = malloc(HEIGHT * WIDTH * sizeof(ull));
+        global_data = grid_buffer_alloc(&global_buf, (size_t) height * width, opts.pages);
         recvcounts = malloc(size * sizeof(int));
         displs = malloc(size * sizeof(int));
+        if (!global_data || !recvcounts || !displs) {
+            fprintf(stderr, "Помилка виділення пам'яті!\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
         for (int p = 0; p < size; p++) {
             int p_rows = (p < remainder) ? (rows_per_proc + 1) : rows_per_proc;
-            recvcounts[p] = p_rows * WIDTH;
+            recvcounts[p] = p_rows * width;
             displs[p] = (p == 0) ? 0 : displs[p - 1] + recvcounts[p - 1];
         }
     }
+    phase_mark(&phases, PHASE_ALLOC);
 
-    MPI_Gatherv(local_data, local_rows * WIDTH, MPI_UNSIGNED_LONG_LONG,
+    long long gather_begin = ring ? trace_now() : 0;
+    MPI_Gatherv(local_data, local_rows * width, MPI_UNSIGNED_LONG_LONG,
                 global_data, recvcounts, displs, MPI_UNSIGNED_LONG_LONG,
                 0, MPI_COMM_WORLD);
+    if (ring) trace_record(ring, TRACE_GATHER, gather_begin, trace_now(), local_rows, 0);
+    phase_mark(&phases, PHASE_GATHER);
 
+    int rc = global_mismatches ? 2 : 0;
+    long long output_begin = ring ? trace_now() : 0;
+    grid_summary summary = {"mpi", size, width, height, grid_kernel_name(plan.kernel), plan.ilp,
+                            plan.e, col_step, global_time, global_min, global_max, {0}};
+    // Енергія обчислення — сума по вузлах
+    int energy_nodes = 0;
+    if (opts.energy) {
+        double local[2] = {phases.joules[PHASE_COMPUTE], phases.has_energy}, total[2] = {0.0, 0.0};
+        MPI_Reduce(local, total, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+        summary.joules = total[0];
+        energy_nodes = (int) total[1];
+    }
     if (rank == 0) {
         printf("\nМінімальне значення шифротексту: %llu\n", global_min);
         printf("Максимальне значення шифротексту: %llu\n", global_max);
         printf("Час виконання: %f секунд\n", global_time);
-        printf("Верхній лівий елемент: %llu\n", global_data[0]);
-        printf("Верхній правий елемент: %llu\n", global_data[WIDTH - 1]);
-        printf("Нижній лівий елемент: %llu\n", global_data[(HEIGHT - 1) * WIDTH]);
-        printf("Нижній правий елемент: %llu\n", global_data[HEIGHT * WIDTH - 1]);
-        printf("Центр: %llu\n", global_data[(HEIGHT / 2) * WIDTH + (WIDTH / 2)]);
+        if (opts.verify)
+            printf("Перевірка (CRT) за %f секунд. Розбіжностей: %lld\n",
+                   verify_time, global_mismatches);
+        if (rc == 0) {
+            grid_probes(global_data, width, height, summary.probes);
+
+            printf("Верхній лівий елемент: %llu\n", summary.probes[0]);
+            printf("Верхній правий елемент: %llu\n", summary.probes[1]);
+            printf("Нижній лівий елемент: %llu\n", summary.probes[2]);
+            printf("Нижній правий елемент: %llu\n", summary.probes[3]);
+            printf("Центр: %llu\n", summary.probes[4]);
+
+            if (opts.checksum) {
+                summary.has_fingerprint = 1;
+                summary.fingerprint = fingerprint_finish(global_fp, width, height);
+                if (report_fingerprint(&summary.fingerprint, opts.golden) != 0) rc = 3;
+            }
+            if (opts.summary) print_summary(&summary);
+            if (opts.output) {
+                gridfile_header hdr;
+                grid_layout rows = {LAYOUT_ROW, width, height};
+                gridfile_header_init(&hdr, &plan, width, height, col_step);
+                if (gridfile_save(opts.output, &hdr, &rows, global_data, global_min, global_max) != 0 && rc == 0)
+                    rc = 1;
+            }
+        }
+        if (ring) trace_record(ring, TRACE_OUTPUT, output_begin, trace_now(), 0, 0);
+    }
+    if (opts.perf) {
+        perf_gather_report(&perf, rank, size);
+        perf_close(&perf);
+    }
+    phase_mark(&phases, PHASE_OUTPUT);
+
+    if (ring && trace_gather_write(&trace, opts.trace, rank, size) != 0 && rc == 0) rc = 1;
+    phase_mark(&phases, PHASE_GATHER);
+
+    // Кожна фаза — максимум по процесах, тобто найповільніший процес у цій
+    // фазі; енергія фази — сума по вузлах
+    if (opts.timing || opts.timing_json || opts.energy) {
+        phase_timer slowest = phases;
+        MPI_Reduce(phases.seconds, slowest.seconds, PHASE_COUNT, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+        if (opts.energy) {
+            MPI_Reduce(phases.joules, slowest.joules, PHASE_COUNT, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+            slowest.has_energy = energy_nodes > 0;
+        }
+        if (rank == 0) {
+            if (opts.timing) phase_report(&slowest);
+            if (opts.timing_json && phase_write_json(&slowest, &summary, opts.timing_json) != 0 && rc == 0)
+                rc = 1;
+            if (slowest.has_energy) phase_energy_report(&slowest, (long long) width * height);
+        }
+    }
+    if (opts.energy) {
+        node_energy_report(&phases, rank, size);
+        if (phases.has_energy) energy_close(&energy);
+        MPI_Comm_free(&node_comm);
     }
 
-    free(local_data);
+    grid_buffer_free(&local_buf);
     if (rank == 0) {
-        free(global_data);
+        grid_buffer_free(&global_buf);
         free(recvcounts);
         free(displs);
     }
 
     MPI_Finalize();
-    return 0;
+    return rc;
 }
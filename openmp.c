@@ -1,9 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <omp.h>
-
-typedef unsigned long long ull;
-typedef long long ll;
+#include "rsa.h"
+#include "options.h"
+#include "report.h"
+#include "thread_stats.h"
+#include "progress.h"
+#include "trace.h"
+#include "timing.h"
+#include "perf_counters.h"
+#include "placement.h"
+#include "gridfile.h"
 
 #define WIDTH 3000
 #define HEIGHT 3000
@@ -13,73 +21,697 @@ const ll q_const = 3000000011LL;
 const ll n_const = p_const * q_const;
 const ll e_const = 900000000000000LL;
 
-ull modexp(ull base, ll exp, ull mod) {
-    ull result = 1;
-    base %= mod;
-    while (exp > 0) {
-        if (exp & 1)
-            result = (result * base) % mod;
-        exp >>= 1;
-        base = (base * base) % mod;
+// Підсумки потоку для плиток: задачі taskloop виконує будь-який потік команди,
+// тож кожна пише в запис того потоку, на якому виконується
+typedef struct {
+    ull min, max;
+    grid_fingerprint fp;
+    long long rows, cells, tiles;
+    double busy;
+} __attribute__((aligned(CACHE_LINE))) tile_acc;
+
+// Спільні дані паралельного обчислення діапазону рядків. Під час
+// калібрування stats, progress і perf — NULL, а трасування вимкнене.
+typedef struct {
+    const modexp_plan *plan;
+    const grid_layout *layout;
+    ull *data;
+    int width;
+    ull col_step;
+    int checksum;
+    int threads;
+    thread_stats *stats;
+    progress_monitor *progress;
+    const trace_log *trace;
+    perf_counters *perf;
+    tile_acc *acc;              // threads записів для SCHED_TILES
+} grid_job;
+
+typedef struct {
+    ull min, max;
+    grid_fingerprint fp;
+    double compute_end;         // потік 0 пройшов бар'єр після обчислення
+    long long reduce_begin;     // те саме в годиннику трасування
+    int perf_available;
+} grid_result;
+
+static int job_perf_open(perf_counters *pc, grid_result *res) {
+    if (!pc) return 0;
+    int available = perf_open(pc);
+    if (omp_get_thread_num() == 0) res->perf_available = available;
+    perf_begin(pc);
+    return available;
+}
+
+// Одиниці розкладки [row_begin, row_end) — рядки або плитки — з розкладом,
+// заданим omp_set_schedule. Цикл з nowait і явний бар'єр після нього, щоб
+// виміряти очікування кожного потоку. Лічильники — локальні змінні потоку,
+// у спільний масив пишуться один раз.
+static void compute_rows(const grid_job *job, int row_begin, int row_end, grid_result *res) {
+    const trace_kind unit_kind = job->layout->kind == LAYOUT_ROW ? TRACE_ROWS : TRACE_TILE;
+    ull global_min = res->min, global_max = res->max;
+    // Лани відбитка окремо, бо reduction не працює з полями структур
+    ull fp_a = 0, fp_b = 0;
+
+    #pragma omp parallel \
+        reduction(min:global_min) \
+        reduction(max:global_max) \
+        reduction(+:fp_a, fp_b)
+    {
+        int tid = omp_get_thread_num();
+        long long rows = 0, cells = 0, chunks = 0;
+        int last_row = -2;
+        progress_slot *slot = job->progress ? &job->progress->slots[tid] : NULL;
+        trace_ring *ring = trace_thread(job->trace, tid);
+        long long chunk_begin = 0;
+        int chunk_first = 0;
+        perf_counters *pc = job->perf ? &job->perf[tid] : NULL;
+        job_perf_open(pc, res);
+        double busy_start = wall_now();
+
+        #pragma omp for schedule(runtime) nowait
+        for (int i = row_begin; i < row_end; i++) {
+            if (i != last_row + 1) {
+                chunks++;
+                // Подія на неперервний діапазон, а не на рядок: кільце не переповнюється
+                if (ring) {
+                    long long now = trace_now();
+                    if (rows)
+                        trace_record(ring, unit_kind, chunk_begin, now, chunk_first,
+                                     last_row - chunk_first + 1);
+                    chunk_begin = now;
+                    chunk_first = i;
+                }
+            }
+            last_row = i;
+            rows++;
+            grid_fingerprint unit_fp = {0, 0};
+            cells += layout_encrypt_unit(job->layout, job->plan, job->col_step, job->data, i,
+                                         &global_min, &global_max, job->checksum ? &unit_fp : NULL);
+            fp_a += unit_fp.a;
+            fp_b += unit_fp.b;
+            if (slot) progress_row_done(slot);
+        }
+
+        if (pc) perf_end(pc, cells);
+        double busy_end = wall_now();
+        long long barrier_begin = ring ? trace_now() : 0;
+        if (ring && rows)
+            trace_record(ring, unit_kind, chunk_begin, barrier_begin, chunk_first,
+                         last_row - chunk_first + 1);
+        #pragma omp barrier
+        // Редукція min/max/відбитка відбувається при виході з паралельної області
+        if (tid == 0) res->compute_end = wall_now();
+        if (ring) {
+            long long now = trace_now();
+            trace_record(ring, TRACE_BARRIER, barrier_begin, now, 0, 0);
+            if (tid == 0) res->reduce_begin = now;
+        }
+        if (job->stats) {
+            thread_stats *s = &job->stats[tid];
+            s->rows = rows;
+            s->cells = cells;
+            s->chunks = chunks;
+            s->busy = busy_end - busy_start;
+            s->wait = wall_now() - busy_end;
+        }
+    }
+
+    res->min = global_min;
+    res->max = global_max;
+    res->fp.a += fp_a;
+    res->fp.b += fp_b;
+}
+
+// Рядки [row_begin, row_end) плитками tile_rows x tile_cols: один потік
+// створює задачі taskloop, решта забирає їх на неявному бар'єрі single.
+// Відрізок рядка в плитці — той самий plan_encrypt_row з іншою основою.
+static void compute_tiles(const grid_job *job, const grid_schedule *sched,
+                          int row_begin, int row_end, grid_result *res) {
+    const int width = job->width, tr = sched->tile_rows, tc = sched->tile_cols;
+    const long tiles_x = (width + tc - 1) / tc;
+    const long tiles = (row_end - row_begin + tr - 1) / tr * tiles_x;
+    tile_acc *acc = job->acc;
+    for (int t = 0; t < job->threads; t++) {
+        memset(&acc[t], 0, sizeof(tile_acc));
+        acc[t].min = res->min;
+        acc[t].max = res->max;
+    }
+
+    #pragma omp parallel
+    {
+        int tid = omp_get_thread_num();
+        perf_counters *pc = job->perf ? &job->perf[tid] : NULL;
+        job_perf_open(pc, res);
+        double start = wall_now();
+
+        #pragma omp single
+        #pragma omp taskloop grainsize(1)
+        for (long t = 0; t < tiles; t++) {
+            int me = omp_get_thread_num();
+            tile_acc *a = &acc[me];
+            trace_ring *ring = trace_thread(job->trace, me);
+            long long tile_begin = ring ? trace_now() : 0;
+            double tile_start = wall_now();
+            int i0 = row_begin + (int)(t / tiles_x) * tr;
+            int i1 = i0 + tr < row_end ? i0 + tr : row_end;
+            int j0 = (int)(t % tiles_x) * tc;
+            int cols = j0 + tc < width ? tc : width - j0;
+            for (int i = i0; i < i1; i++) {
+                ull *seg = &job->data[(size_t)i * width + j0];
+                ull first = (ull)i * width + (ull)j0;
+                plan_encrypt_row(job->plan, (ull)i * width + (ull)j0 * job->col_step, job->col_step,
+                                 seg, cols, &a->min, &a->max);
+                if (job->checksum) fingerprint_add(&a->fp, fingerprint_row(first, seg, cols));
+                if (job->progress) progress_row_done(&job->progress->slots[me]);
+            }
+            a->rows += i1 - i0;
+            a->cells += (long long)(i1 - i0) * cols;
+            a->tiles++;
+            a->busy += wall_now() - tile_start;
+            if (ring) trace_record(ring, TRACE_TILE, tile_begin, trace_now(), t, i1 - i0);
+        }
+
+        if (pc) perf_end(pc, acc[tid].cells);
+        if (tid == 0) {
+            res->compute_end = wall_now();
+            res->reduce_begin = trace_thread(job->trace, 0) ? trace_now() : 0;
+        }
+        if (job->stats) {
+            thread_stats *s = &job->stats[tid];
+            s->rows = acc[tid].rows;
+            s->cells = acc[tid].cells;
+            s->chunks = acc[tid].tiles;
+            s->busy = acc[tid].busy;
+            s->wait = wall_now() - start - acc[tid].busy;
+        }
+    }
+
+    for (int t = 0; t < job->threads; t++) {
+        if (acc[t].min < res->min) res->min = acc[t].min;
+        if (acc[t].max > res->max) res->max = acc[t].max;
+        fingerprint_add(&res->fp, acc[t].fp);
+    }
+}
+
+// Розклад для циклів schedule(runtime); SCHED_TILES сюди не доходить
+static void apply_schedule(const grid_schedule *sched) {
+    switch (sched->kind) {
+        case SCHED_STATIC:
+            omp_set_schedule(omp_sched_static, sched->chunk);
+            break;
+        case SCHED_GUIDED:
+            omp_set_schedule(omp_sched_guided, sched->chunk);
+            break;
+        case SCHED_DYNAMIC:
+            omp_set_schedule(omp_sched_dynamic, sched->chunk);
+            break;
+        default:
+            omp_set_schedule(omp_sched_dynamic, 1);
+            break;
+    }
+}
+
+static void compute(const grid_job *job, const grid_schedule *sched,
+                    int row_begin, int row_end, grid_result *res) {
+    if (sched->kind == SCHED_TILES) {
+        compute_tiles(job, sched, row_begin, row_end, res);
+        return;
+    }
+    apply_schedule(sched);
+    compute_rows(job, row_begin, row_end, res);
+}
+
+// Частка сітки для калібрування і варіанти, які на ній порівнюються
+#define TUNE_SLICE_DIVISOR 64
+#define TUNE_MIN_ROWS_PER_THREAD 4
+
+static const grid_schedule tune_candidates[] = {
+    {SCHED_STATIC, 0, 0, 0},
+    {SCHED_STATIC, 1, 0, 0},
+    {SCHED_DYNAMIC, 1, 0, 0},
+    {SCHED_DYNAMIC, 8, 0, 0},
+    {SCHED_GUIDED, 1, 0, 0},
+    {SCHED_TILES, 0, 16, 512},
+};
+
+// Міряє кожен варіант на перших рядках сітки (результати ті самі, тож вони
+// просто перезаписуються) і повертає найшвидший
+static grid_schedule autotune(const grid_job *job, int height) {
+    // height — кількість одиниць розкладки
+    grid_job probe = *job;
+    trace_log off = {NULL, 0, 0};
+    probe.stats = NULL;
+    probe.progress = NULL;
+    probe.perf = NULL;
+    probe.trace = &off;
+
+    int slice = height / TUNE_SLICE_DIVISOR;
+    if (slice < TUNE_MIN_ROWS_PER_THREAD * job->threads) slice = TUNE_MIN_ROWS_PER_THREAD * job->threads;
+    if (slice > height) slice = height;
+
+    // Плитки taskloop — лише для построкової розкладки, вони останні в списку
+    int count = sizeof(tune_candidates) / sizeof(tune_candidates[0]);
+    if (job->layout->kind != LAYOUT_ROW) count--;
+    int best = 0;
+    double best_time = 0.0;
+    char name[32];
+    printf("Автопідбір розкладу на %d %s:", slice, job->layout->kind == LAYOUT_ROW ? "рядках" : "плитках");
+    // Перший прогін — розігрів: потоки, сторінки, кеш інструкцій
+    grid_result warm = {job->plan->n, 0, {0, 0}, 0.0, 0, 0};
+    compute(&probe, &tune_candidates[0], 0, slice, &warm);
+    for (int c = 0; c < count; c++) {
+        grid_result r = {job->plan->n, 0, {0, 0}, 0.0, 0, 0};
+        double t0 = wall_now();
+        compute(&probe, &tune_candidates[c], 0, slice, &r);
+        double t = wall_now() - t0;
+        grid_schedule_format(&tune_candidates[c], name, sizeof(name));
+        printf(" %s %.3f мс%s", name, t * 1e3, c + 1 < count ? "," : "");
+        if (c == 0 || t < best_time) {
+            best = c;
+            best_time = t;
+        }
+    }
+    grid_schedule_format(&tune_candidates[best], name, sizeof(name));
+    printf("\nОбрано розклад %s\n", name);
+    return tune_candidates[best];
+}
+
+// Режим --exponents: по сітці на кожну експоненту, квадрати повідомлення
+// рахуються один раз для всіх. Рядки роздаються з --schedule (без tiles та
+// auto), min/max і лани відбитків редукуються секціями масивів.
+static int run_exponents(const grid_options *opts, const modexp_plan *plan,
+                         int width, int height, ull col_step) {
+    const int count = opts->exponent_count;
+    grid_buffer bufs[MULTI_EXP_MAX];
+    ull *grids[MULTI_EXP_MAX];
+    ull mins[MULTI_EXP_MAX], maxs[MULTI_EXP_MAX], fp_a[MULTI_EXP_MAX], fp_b[MULTI_EXP_MAX];
+    for (int k = 0; k < count; k++) {
+        grids[k] = grid_buffer_alloc(&bufs[k], (size_t)width * height, opts->pages);
+        if (!grids[k]) {
+            fprintf(stderr, "Помилка виділення пам'яті!\n");
+            while (k--) grid_buffer_free(&bufs[k]);
+            return 1;
+        }
+        mins[k] = plan->n;
+        maxs[k] = fp_a[k] = fp_b[k] = 0;
+    }
+
+    grid_schedule sched = opts->schedule;
+    if (sched.kind == SCHED_TILES || sched.kind == SCHED_AUTO) sched.kind = SCHED_DEFAULT;
+    apply_schedule(&sched);
+
+    double t0 = wall_now();
+    #pragma omp parallel for schedule(runtime) \
+        reduction(min:mins[:count]) reduction(max:maxs[:count]) reduction(+:fp_a[:count], fp_b[:count])
+    for (int i = 0; i < height; i++) {
+        ull *rows[MULTI_EXP_MAX];
+        for (int k = 0; k < count; k++) rows[k] = &grids[k][(size_t)i * width];
+        plan_encrypt_row_multi(plan, opts->exponents, count, (ull)i * width, col_step,
+                               rows, width, mins, maxs);
+        if (opts->checksum) {
+            for (int k = 0; k < count; k++) {
+                grid_fingerprint row_fp = fingerprint_row((ull)i * width, rows[k], width);
+                fp_a[k] += row_fp.a;
+                fp_b[k] += row_fp.b;
+            }
+        }
     }
-    return result;
+    double elapsed = wall_now() - t0;
+
+    char sched_name[32];
+    grid_schedule_format(&sched, sched_name, sizeof(sched_name));
+    printf("Згенеровано %d сіток %dx%d за %f секунд. Розклад: %s\n", count, width, height, elapsed,
+           sched_name);
+    if (plan->kernel != KERNEL_CT) report_multi_cost(opts->exponents, count);
+    for (int k = 0; k < count; k++) {
+        grid_summary summary = {"openmp", omp_get_max_threads(), width, height, grid_kernel_name(plan->kernel),
+                                plan->ilp, opts->exponents[k], col_step, elapsed, mins[k], maxs[k], {0}};
+        grid_probes(grids[k], width, height, summary.probes);
+        if (opts->checksum) {
+            summary.has_fingerprint = 1;
+            summary.fingerprint = fingerprint_finish((grid_fingerprint){fp_a[k], fp_b[k]}, width, height);
+        }
+        report_exponent(&summary, opts->summary);
+        grid_buffer_free(&bufs[k]);
+    }
+    return 0;
 }
 
-int main() {
+// Режим --extend: нова сітка пишеться блоками по EXTEND_BLOCK_ROWS рядків,
+// потоки ділять рядки блоку, шифруючи лише клітинки поза збереженою сіткою
+#define EXTEND_BLOCK_ROWS 64
+
+static int run_extend(const grid_options *opts, const modexp_plan *plan, int width, int height) {
+    gridfile_map old;
+    grid_extension x;
+    gridfile_writer w;
+    ull min, max;
+    if (gridfile_open(&old, opts->extend) != 0) return 1;
+    if (grid_extension_init(&x, plan, &old, width, height) != 0 ||
+        grid_extension_begin(&x, &w, opts->output ? opts->output : opts->extend, &min, &max) != 0) {
+        gridfile_close(&old);
+        return 1;
+    }
+    ull *block = malloc((size_t)EXTEND_BLOCK_ROWS * width * sizeof(ull));
+    if (!block) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        gridfile_abort(&w);
+        gridfile_close(&old);
+        return 1;
+    }
+
+    double t0 = wall_now();
+    long long computed = 0;
+    for (int first = 0; first < height; first += EXTEND_BLOCK_ROWS) {
+        int rows = height - first < EXTEND_BLOCK_ROWS ? height - first : EXTEND_BLOCK_ROWS;
+        #pragma omp parallel for schedule(dynamic) reduction(min:min) reduction(max:max) reduction(+:computed)
+        for (int r = 0; r < rows; r++)
+            computed += grid_extension_row(&x, first + r, &block[(size_t)r * width], &min, &max);
+        if (gridfile_write_rows(&w, block, rows) != 0) {
+            free(block);
+            gridfile_abort(&w);
+            gridfile_close(&old);
+            return 1;
+        }
+    }
+
+    grid_summary summary = {"openmp", omp_get_max_threads(), width, height, grid_kernel_name(plan->kernel),
+                            plan->ilp, plan->e, x.col_step, wall_now() - t0, min, max, {0}};
+    int rc = grid_extension_finish(&x, &w, opts, &summary, computed, min, max);
+    free(block);
+    gridfile_close(&old);
+    return rc;
+}
+
+// Вибірка --preview блоками по PREVIEW_BLOCK повідомлень
+static void preview_encrypt(void *ctx, const ull *messages, ull *out, long count) {
+    const modexp_plan *plan = ctx;
+    #pragma omp parallel for schedule(dynamic)
+    for (long b = 0; b < count; b += PREVIEW_BLOCK)
+        plan_encrypt_messages(plan, messages + b, out + b, count - b < PREVIEW_BLOCK ? count - b : PREVIEW_BLOCK);
+}
+
+int main(int argc, char *argv[]) {
     int i, j;
 
-    ull global_min = n_const;
-    ull global_max = 0;
+    grid_options opts;
+    rsa_key key;
+    modexp_plan plan;
+    if (parse_options(argc, argv, &opts) != 0) return 1;
+    if (options_setup(&opts, n_const, e_const, &key, &plan) != 0) return 1;
+
+    int width = opts.width ? opts.width : WIDTH;
+    int height = opts.height ? opts.height : HEIGHT;
+    // Повідомлення клітинки (i, j) — i * width + j * col_step, за замовчуванням (i + j) * width
+    ull col_step = grid_col_step(&opts, FORMULA_DIAG, width);
+    if (opts.exponent_count) return run_exponents(&opts, &plan, width, height, col_step);
+    if (opts.extend) return run_extend(&opts, &plan, width, height);
+    if (opts.preview > 0.0) {
+        preview_config cfg = {width, height, col_step, plan.n, opts.preview, opts.preview_eps, PREVIEW_SEED};
+        preview_result res;
+        if (preview_run(&cfg, preview_encrypt, NULL, &plan, &res) != 0) return 1;
+        preview_report(&cfg, &res, "openmp", omp_get_max_threads(), opts.summary);
+        return 0;
+    }
+
+    phase_timer phases;
+    phase_init(&phases);
+    energy_meter energy;
+    if (opts.energy) {
+        if (energy_open(&energy, ENERGY_SYSFS) == 0) phase_attach_energy(&phases, &energy);
+        else fprintf(stderr, ENERGY_UNAVAILABLE_MSG);
+    }
 
-    ull *data = malloc(WIDTH * HEIGHT * sizeof(ull));
+    // Потоки ділять одиниці розкладки: рядки або цілі плитки
+    grid_layout layout;
+    if (grid_layout_init(&layout, opts.layout, width, height, opts.layout_tile) != 0) {
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    int units = grid_layout_units(&layout);
+    size_t unit_cells = grid_layout_unit_cells(&layout);
+
+    grid_buffer data_buf;
+    ull *data = grid_buffer_alloc(&data_buf, grid_layout_cells(&layout), opts.pages);
     if (!data) {
         fprintf(stderr, "Помилка виділення пам'яті!\n");
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+
+    int max_threads = omp_get_max_threads();
+    if (opts.numa == NUMA_BIND && !placement_has_libnuma()) {
+        fprintf(stderr, "--numa=bind потребує libnuma і ядра з NUMA\n");
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
         return 1;
     }
 
-    double t0 = omp_get_wtime();
+    // Розміщення: прив'язка потоків і перше торкання сторінок тим потоком,
+    // який потім пише ці рядки. Пул потоків OpenMP переживає область,
+    // тож прив'язка діє й у циклі обчислення.
+    int rows_per_thread = placement_rows_per_thread(units, max_threads);
+    thread_placement *places = NULL;
+    if (opts.numa || opts.pin) {
+        static int cpus[PLACEMENT_MAX_CPUS];
+        int ncpus = placement_cpus(cpus, PLACEMENT_MAX_CPUS);
+        places = aligned_alloc(CACHE_LINE, max_threads * sizeof(thread_placement));
+        if (!places) {
+            fprintf(stderr, "Помилка виділення пам'яті!\n");
+            grid_buffer_free(&data_buf);
+            grid_layout_free(&layout);
+            if (phases.has_energy) energy_close(&energy);
+            return 1;
+        }
+        memset(places, 0, max_threads * sizeof(thread_placement));
 
-    long long max_threads = omp_get_max_threads();
-    long long *rows_processed = calloc(max_threads, sizeof(long long));
-    if (!rows_processed) {
-        fprintf(stderr, "Помилка виділення rows_processed!\n");
-        free(data);
+        #pragma omp parallel
+        {
+            int tid = omp_get_thread_num();
+            thread_placement *p = &places[tid];
+            if (opts.pin && ncpus > 0) p->pinned = placement_pin(cpus[tid % ncpus]) == 0;
+            placement_current(&p->cpu, &p->node);
+            if (opts.numa) {
+                p->row_begin = tid * rows_per_thread < units ? tid * rows_per_thread : units;
+                p->row_end = p->row_begin + rows_per_thread < units ? p->row_begin + rows_per_thread : units;
+                ull *block = &data[(size_t)p->row_begin * unit_cells];
+                size_t bytes = (size_t)(p->row_end - p->row_begin) * unit_cells * sizeof(ull);
+                if (opts.numa == NUMA_BIND && p->node >= 0) placement_bind(block, bytes, p->node);
+                memset(block, 0, bytes);
+            }
+        }
+        placement_report(places, max_threads);
+        free(places);
+    }
+
+    thread_stats *stats = thread_stats_alloc(max_threads);
+    tile_acc *acc = aligned_alloc(CACHE_LINE, max_threads * sizeof(tile_acc));
+    if (!stats || !acc) {
+        fprintf(stderr, "Помилка виділення лічильників потоків!\n");
+        free(stats);
+        free(acc);
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
         return 1;
     }
 
-    #pragma omp parallel for private(j) \
-        reduction(min:global_min) \
-        reduction(max:global_max) \
-        schedule(dynamic)
-    for (i = 0; i < HEIGHT; i++) {
-        int tid = omp_get_thread_num();
-        rows_processed[tid]++;
-        for (j = 0; j < WIDTH; j++) {
-            ll message = (i + j) * WIDTH;
-            ull ciphertext = modexp(message, e_const, n_const);
-            data[i * WIDTH + j] = ciphertext;
+    grid_job job = {&plan, &layout, data, width, col_step, opts.checksum, max_threads,
+                    stats, NULL, NULL, NULL, acc};
+
+    // З --numa рядки роздаються тими ж блоками, що й при першому торканні
+    grid_schedule sched = opts.schedule;
+    if (opts.numa) {
+        if (sched.kind != SCHED_DEFAULT)
+            fprintf(stderr, "--numa задає розклад static блоками по %d рядків, --schedule ігнорується\n",
+                    rows_per_thread);
+        sched.kind = SCHED_STATIC;
+        sched.chunk = rows_per_thread;
+    } else if (sched.kind == SCHED_TILES && layout.kind != LAYOUT_ROW) {
+        // Плитки вже задає розкладка
+        fprintf(stderr, "--schedule=tiles з --layout=%s замінено на dynamic по плитці розкладки\n",
+                grid_layout_name(layout.kind));
+        sched.kind = SCHED_DEFAULT;
+    } else if (sched.kind == SCHED_AUTO) {
+        sched = autotune(&job, units);
+    }
+    // Перше торкання, прив'язка й калібрування розкладу — підготовка, не обчислення
+    phase_mark(&phases, PHASE_ALLOC);
+
+    // Для плиток taskloop одиниця прогресу — відрізок рядка в плитці,
+    // для плиткової розкладки — плитка
+    long long progress_units = units;
+    int progress_width = (int)((long long)width * height / units);
+    if (sched.kind == SCHED_TILES) {
+        int tiles_x = (width + sched.tile_cols - 1) / sched.tile_cols;
+        progress_units = (long long)height * tiles_x;
+        progress_width = (width + tiles_x - 1) / tiles_x;
+    }
+    progress_monitor progress;
+    if (progress_init(&progress, "openmp", max_threads, progress_units, progress_width,
+                      opts.progress, opts.progress_file) != 0) {
+        fprintf(stderr, "Помилка виділення лічильників прогресу!\n");
+        free(stats);
+        free(acc);
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    if (opts.progress > 0.0 && progress_start(&progress) != 0)
+        fprintf(stderr, "Не вдалося запустити потік прогресу\n");
+
+    trace_log trace;
+    if (trace_init(&trace, opts.trace != NULL, max_threads, 0) != 0) {
+        fprintf(stderr, "Помилка виділення буфера трасування!\n");
+        if (opts.progress > 0.0) progress_stop(&progress);
+        progress_free(&progress);
+        free(stats);
+        free(acc);
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    trace_ring *main_ring = trace_thread(&trace, 0);
 
-            if (ciphertext < global_min) global_min = ciphertext;
-            if (ciphertext > global_max) global_max = ciphertext;
+    // Лічильники відкриває кожен потік для себе, всередині паралельної області
+    perf_counters *perf = NULL;
+    if (opts.perf) {
+        perf = aligned_alloc(CACHE_LINE, max_threads * sizeof(perf_counters));
+        if (!perf) {
+            fprintf(stderr, "Помилка виділення лічильників perf!\n");
+            trace_free(&trace);
+            if (opts.progress > 0.0) progress_stop(&progress);
+            progress_free(&progress);
+            free(stats);
+            free(acc);
+            grid_buffer_free(&data_buf);
+            grid_layout_free(&layout);
+            if (phases.has_energy) energy_close(&energy);
+            return 1;
         }
+        for (int t = 0; t < max_threads; t++) perf_clear(&perf[t]);
     }
+    job.progress = &progress;
+    job.trace = &trace;
+    job.perf = perf;
 
-    double t1 = omp_get_wtime();
+    double t0 = wall_now();
+    phase_mark_at(&phases, PHASE_ALLOC, t0);
+
+    grid_result result = {plan.n, 0, {0, 0}, 0.0, 0, 0};
+    compute(&job, &sched, 0, units, &result);
+
+    double t1 = wall_now();
+    ull global_min = result.min, global_max = result.max;
+    if (main_ring) trace_record(main_ring, TRACE_REDUCE, result.reduce_begin, trace_now(), 0, 0);
+    phase_mark_at(&phases, PHASE_COMPUTE, result.compute_end);
+    phase_mark_at(&phases, PHASE_REDUCE, t1);
+    // Зупинка монітора — завершення обчислення, не збір результату
+    if (opts.progress > 0.0) progress_stop(&progress);
+    progress_free(&progress);
+    phase_mark(&phases, PHASE_REDUCE);
 
     printf("Згенеровано зображення %dx%d за %f секунд. min = %llu, max = %llu\n",
-           WIDTH, HEIGHT, t1 - t0, global_min, global_max);
-    for (i = 0; i < max_threads; i++) {
-        printf("Thread %d обробив %lld рядків\n", i, rows_processed[i]);
+           width, height, t1 - t0, global_min, global_max);
+    char sched_name[32];
+    grid_schedule_format(&sched, sched_name, sizeof(sched_name));
+    if (layout.kind == LAYOUT_ROW) printf("Розклад: %s\n", sched_name);
+    else printf("Розклад: %s, розкладка %s %dx%d\n", sched_name, grid_layout_name(layout.kind),
+                layout.tile, layout.tile);
+    thread_stats_report(stats, max_threads);
+    if (perf) {
+        if (!result.perf_available) fprintf(stderr, PERF_UNAVAILABLE_MSG);
+        perf_report(perf, max_threads, "Потік");
+        for (int t = 0; t < max_threads; t++) perf_close(&perf[t]);
+        free(perf);
     }
+    phase_mark(&phases, PHASE_OUTPUT);
 
-    printf("Верхній лівий: %llu\n", data[0]);
-    printf("Верхній правий: %llu\n", data[WIDTH - 1]);
-    printf("Нижній лівий: %llu\n", data[(HEIGHT - 1) * WIDTH]);
-    printf("Нижній правий: %llu\n", data[HEIGHT * WIDTH - 1]);
-    printf("Центр: %llu\n", data[(HEIGHT / 2) * WIDTH + (WIDTH / 2)]);
+    // Після розбіжностей результат не друкується, але звіти фаз, енергія
+    // й звільнення — спільні
+    int rc = 0;
+    if (opts.verify) {
+        ll mismatches = 0, reported = 0;
+        long long verify_begin = main_ring ? trace_now() : 0;
 
-    free(rows_processed);
-    free(data);
+        #pragma omp parallel for private(j) reduction(+:mismatches) schedule(dynamic)
+        for (i = 0; i < height; i++) {
+            ull ciphertexts[ILP_MAX], decrypted[ILP_MAX];
+            for (j = 0; j < width; j += plan.ilp) {
+                int count = width - j < plan.ilp ? width - j : plan.ilp;
+                for (int k = 0; k < count; k++) ciphertexts[k] = grid_layout_at(&layout, data, i, j + k);
+                plan_decrypt_batch(&plan, &key, ciphertexts, decrypted, count);
+                for (int k = 0; k < count; k++) {
+                    ull message = (ull)i * width + (j + k) * col_step;
+                    if (decrypted[k] != message) {
+                        // mismatches — приватна копія потоку, тож ліміт друку — спільний лічильник
+                        ll seen;
+                        #pragma omp atomic capture
+                        seen = reported++;
+                        if (seen < VERIFY_REPORT_LIMIT) {
+                            #pragma omp critical(verify_report)
+                            rsa_report_mismatch(i, j + k, message, ciphertexts[k], decrypted[k]);
+                        }
+                        mismatches++;
+                    }
+                }
+            }
+        }
 
-    return 0;
-}
\ No newline at end of file
+        printf("Перевірка (CRT) за %f секунд. Розбіжностей: %lld\n",
+               phase_mark(&phases, PHASE_VERIFY), mismatches);
+        if (main_ring) trace_record(main_ring, TRACE_VERIFY, verify_begin, trace_now(), mismatches, 0);
+        if (mismatches) rc = 2;
+    }
+
+    grid_summary summary = {"openmp", max_threads, width, height,
+                            grid_kernel_name(plan.kernel), plan.ilp, plan.e, col_step,
+                            t1 - t0, global_min, global_max, {0}};
+    if (rc == 0) {
+        long long output_begin = main_ring ? trace_now() : 0;
+        grid_probes_layout(&layout, data, summary.probes);
+
+        printf("Верхній лівий: %llu\n", summary.probes[0]);
+        printf("Верхній правий: %llu\n", summary.probes[1]);
+        printf("Нижній лівий: %llu\n", summary.probes[2]);
+        printf("Нижній правий: %llu\n", summary.probes[3]);
+        printf("Центр: %llu\n", summary.probes[4]);
+
+        if (opts.checksum) {
+            summary.has_fingerprint = 1;
+            summary.fingerprint = fingerprint_finish(result.fp, width, height);
+            if (report_fingerprint(&summary.fingerprint, opts.golden) != 0) rc = 3;
+        }
+        summary.joules = phases.joules[PHASE_COMPUTE];
+        if (opts.summary) print_summary(&summary);
+        if (main_ring) trace_record(main_ring, TRACE_OUTPUT, output_begin, trace_now(), 0, 0);
+        phase_mark(&phases, PHASE_OUTPUT);
+        if (opts.output) {
+            gridfile_header hdr;
+            gridfile_header_init(&hdr, &plan, width, height, col_step);
+            if (gridfile_save(opts.output, &hdr, &layout, data, global_min, global_max) != 0 && rc == 0) rc = 1;
+        }
+    }
+    if (trace_finish(&trace, opts.trace, "openmp") != 0 && rc == 0) rc = 1;
+    phase_mark(&phases, PHASE_GATHER);
+
+    if (opts.timing) phase_report(&phases);
+    if (opts.timing_json && phase_write_json(&phases, &summary, opts.timing_json) != 0 && rc == 0) rc = 1;
+    if (phases.has_energy) {
+        phase_energy_report(&phases, (long long)width * height);
+        energy_report(&energy);
+        energy_close(&energy);
+    }
+
+    free(stats);
+    free(acc);
+    grid_buffer_free(&data_buf);
+    grid_layout_free(&layout);
+
+    return rc;
+}
@@ -0,0 +1,313 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "options.h"
+
+// Чотири ланцюжки перекривають затримку множення на більшості ядер x86-64,
+// див. bench_kernels для власної машини
+#define ILP_DEFAULT 4
+
+// Плитка за замовчуванням: 16 x 512 клітинок, 64 КБ результату
+#define TILE_ROWS_DEFAULT 16
+#define TILE_COLS_DEFAULT 512
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Використання: %s [--verify] [--key=p,q,e[,d]] [--kernel=legacy|u128|ct|barrett|mont] [--ilp=N]\n"
+            "       [--size=WxH] [--e=N] [--formula=row|diag] [--summary]\n"
+            "       [--checksum] [--golden=HEX] [--progress[=SEC]] [--progress-file=PATH]\n"
+            "       [--trace=PATH] [--timing] [--timing-json=PATH] [--perf] [--energy]\n"
+            "       [--numa[=touch|bind]] [--pin] [--hugepages[=thp|hugetlb]] [--stream]\n"
+            "       [--schedule=static|dynamic|guided[,CHUNK]|tiles[,RxC]|auto]\n"
+            "       [--threads=N] [--tile-rows=N] [--layout=row|tiled|morton[,T]]\n"
+            "       [--exponents=E1,E2,...] [--preview[=SEC]] [--preview-eps=X]\n"
+            "       [--output=PATH] [--extend=PATH]\n"
+            "  --verify         зашифрувати сітку ключем з CRT-параметрами та перевірити розшифруванням\n"
+            "  --key=p,q,e[,d]  ключ для --verify (p, q < 2^32 прості; d обчислюється, якщо не задано)\n"
+            "  --kernel=...     ядро modexp; ct — сталочасові сходинки Монтгомері\n"
+            "  --ilp=N          чергувати N (1..%d) клітинок рядка в одному ядрі, за замовчуванням %d\n"
+            "  --size=WxH       розмір сітки замість вбудованого в драйвер\n"
+            "  --e=N            експонента замість e_const драйвера\n"
+            "  --formula=...    повідомлення клітинки: row = i*W + j (seq), diag = (i + j)*W (openmp, mpi)\n"
+            "  --summary        надрукувати машиночитний рядок RESULT\n"
+            "  --checksum       порахувати 128-бітний відбиток усієї сітки\n"
+            "  --golden=HEX     порівняти відбиток з еталоном, код виходу 3 при розбіжності\n"
+            "  --progress[=SEC] періодично писати прогрес у форматі Prometheus у stderr (за замовчуванням 1 с)\n"
+            "  --progress-file=PATH  писати прогрес у файл (для node_exporter textfile)\n"
+            "  --trace=PATH     записати часову шкалу потоків і процесів (chrome://tracing, Perfetto)\n"
+            "  --timing         надрукувати час фаз: виділення, обчислення, редукція, збір/IO, перевірка, вивід\n"
+            "  --timing-json=PATH  записати фази та підсумок у JSON (\"-\" — stdout)\n"
+            "  --perf           лічильники циклів, інструкцій, промахів і зайнятості дільника на потік\n"
+            "  --energy         енергія RAPL (powercap) за фазами, Дж на мільйон клітинок\n"
+            "  --numa[=touch|bind]  рядки потокам блоками; сторінки торкає потік-власник (bind — ще й libnuma)\n"
+            "  --pin            прив'язати потоки OpenMP до CPU по колу і надрукувати розміщення\n"
+            "  --hugepages[=...]  буфери сітки на 2 МБ сторінках: thp (madvise, за замовчуванням) чи hugetlb\n"
+            "  --stream         писати рядки сітки повз кеш (movnti); з --checksum рядок читається з пам'яті\n"
+            "  --schedule=...   розподіл рядків у openmp: static, dynamic, guided з порцією CHUNK,\n"
+            "                   плитки RxC через taskloop або auto — підбір на частині сітки\n"
+            "  --threads=N      виконавців пулу з крадіжкою роботи (pthreads), за замовчуванням — CPU\n"
+            "  --tile-rows=N    рядків у задачі пулу pthreads\n"
+            "  --layout=...     розкладка сітки: row, плитки TxT построково (tiled) чи за Мортоном (morton)\n"
+            "  --exponents=...  до %d експонент зі спільним ланцюжком квадратів, по сітці на кожну\n"
+            "  --preview[=SEC]  оцінити статистики за стратифікованою вибіркою в межах бюджету (1 с)\n"
+            "  --preview-eps=X  зупинити вибірку, щойно відносна похибка середнього <= X (%g, 0 — лише бюджет)\n"
+            "  --output=PATH    записати сітку у файл результату\n"
+            "  --extend=PATH    дорахувати збережену сітку до --size: шифруються лише нові клітинки,\n"
+            "                   результат — у --output або на місце PATH\n",
+            prog, ILP_MAX, ILP_DEFAULT, MULTI_EXP_MAX, PREVIEW_EPS_DEFAULT);
+}
+
+static const char *sched_names[] = {"default", "static", "dynamic", "guided", "tiles", "auto"};
+
+static int parse_schedule(const char *text, grid_schedule *s) {
+    s->kind = SCHED_DEFAULT;
+    s->chunk = 0;
+    s->tile_rows = TILE_ROWS_DEFAULT;
+    s->tile_cols = TILE_COLS_DEFAULT;
+    size_t len = strcspn(text, ",");
+    for (grid_sched k = SCHED_STATIC; k <= SCHED_AUTO; k++)
+        if (strlen(sched_names[k]) == len && strncmp(text, sched_names[k], len) == 0) s->kind = k;
+    if (s->kind == SCHED_DEFAULT) return -1;
+    if (text[len] == '\0') return 0;
+
+    const char *arg = text + len + 1;
+    if (s->kind == SCHED_TILES)
+        return sscanf(arg, "%dx%d", &s->tile_rows, &s->tile_cols) == 2 &&
+               s->tile_rows > 0 && s->tile_cols > 0 ? 0 : -1;
+    if (s->kind == SCHED_AUTO) return -1;
+    s->chunk = atoi(arg);
+    return s->chunk > 0 ? 0 : -1;
+}
+
+void grid_schedule_format(const grid_schedule *s, char *out, size_t size) {
+    if (s->kind == SCHED_TILES)
+        snprintf(out, size, "tiles,%dx%d", s->tile_rows, s->tile_cols);
+    else if (s->kind == SCHED_DEFAULT)
+        snprintf(out, size, "dynamic,1");
+    else if (s->chunk > 0)
+        snprintf(out, size, "%s,%d", sched_names[s->kind], s->chunk);
+    else
+        snprintf(out, size, "%s", sched_names[s->kind]);
+}
+
+int parse_options(int argc, char *argv[], grid_options *opts) {
+    memset(opts, 0, sizeof(*opts));
+    opts->ilp = ILP_DEFAULT;
+    opts->preview_eps = PREVIEW_EPS_DEFAULT;
+    for (int a = 1; a < argc; a++) {
+        const char *arg = argv[a];
+        if (strcmp(arg, "--verify") == 0) {
+            opts->verify = 1;
+        } else if (strncmp(arg, "--key=", 6) == 0) {
+            int got = sscanf(arg + 6, "%llu,%llu,%llu,%llu",
+                             &opts->key_p, &opts->key_q, &opts->key_e, &opts->key_d);
+            if (got < 3) {
+                fprintf(stderr, "Некоректний ключ: %s\n", arg);
+                return -1;
+            }
+        } else if (strncmp(arg, "--kernel=", 9) == 0) {
+            const char *name = arg + 9;
+            if (strcmp(name, "legacy") == 0) opts->kernel = KERNEL_LEGACY;
+            else if (strcmp(name, "u128") == 0) opts->kernel = KERNEL_U128;
+            else if (strcmp(name, "ct") == 0) opts->kernel = KERNEL_CT;
+            else if (strcmp(name, "barrett") == 0) opts->kernel = KERNEL_BARRETT;
+            else if (strcmp(name, "mont") == 0) opts->kernel = KERNEL_MONT;
+            else {
+                fprintf(stderr, "Невідоме ядро: %s\n", name);
+                return -1;
+            }
+        } else if (strncmp(arg, "--ilp=", 6) == 0) {
+            opts->ilp = atoi(arg + 6);
+            if (opts->ilp < 1 || opts->ilp > ILP_MAX) {
+                fprintf(stderr, "--ilp має бути від 1 до %d\n", ILP_MAX);
+                return -1;
+            }
+        } else if (strncmp(arg, "--size=", 7) == 0) {
+            if (sscanf(arg + 7, "%dx%d", &opts->width, &opts->height) != 2 ||
+                opts->width < 1 || opts->height < 1) {
+                fprintf(stderr, "Некоректний розмір: %s\n", arg);
+                return -1;
+            }
+        } else if (strncmp(arg, "--e=", 4) == 0) {
+            opts->e = strtoull(arg + 4, NULL, 10);
+            if (opts->e == 0) {
+                fprintf(stderr, "Некоректна експонента: %s\n", arg);
+                return -1;
+            }
+        } else if (strncmp(arg, "--formula=", 10) == 0) {
+            const char *name = arg + 10;
+            if (strcmp(name, "row") == 0) opts->formula = FORMULA_ROW;
+            else if (strcmp(name, "diag") == 0) opts->formula = FORMULA_DIAG;
+            else {
+                fprintf(stderr, "Невідома формула: %s\n", name);
+                return -1;
+            }
+        } else if (strcmp(arg, "--summary") == 0) {
+            opts->summary = 1;
+        } else if (strcmp(arg, "--progress") == 0) {
+            opts->progress = 1.0;
+        } else if (strncmp(arg, "--progress=", 11) == 0) {
+            opts->progress = atof(arg + 11);
+            if (opts->progress <= 0.0) {
+                fprintf(stderr, "Некоректний інтервал: %s\n", arg);
+                return -1;
+            }
+        } else if (strncmp(arg, "--progress-file=", 16) == 0) {
+            opts->progress_file = arg + 16;
+            if (opts->progress == 0.0) opts->progress = 1.0;
+        } else if (strncmp(arg, "--trace=", 8) == 0) {
+            opts->trace = arg + 8;
+            if (*opts->trace == '\0') {
+                fprintf(stderr, "Порожній шлях для --trace\n");
+                return -1;
+            }
+        } else if (strcmp(arg, "--timing") == 0) {
+            opts->timing = 1;
+        } else if (strncmp(arg, "--timing-json=", 14) == 0) {
+            opts->timing_json = arg + 14;
+        } else if (strcmp(arg, "--perf") == 0) {
+            opts->perf = 1;
+        } else if (strcmp(arg, "--energy") == 0) {
+            opts->energy = 1;
+        } else if (strcmp(arg, "--numa") == 0 || strcmp(arg, "--numa=touch") == 0) {
+            opts->numa = NUMA_TOUCH;
+        } else if (strcmp(arg, "--numa=bind") == 0) {
+            opts->numa = NUMA_BIND;
+        } else if (strcmp(arg, "--pin") == 0) {
+            opts->pin = 1;
+        } else if (strcmp(arg, "--hugepages") == 0 || strcmp(arg, "--hugepages=thp") == 0) {
+            opts->pages = PAGES_THP;
+        } else if (strcmp(arg, "--hugepages=hugetlb") == 0) {
+            opts->pages = PAGES_HUGETLB;
+        } else if (strcmp(arg, "--stream") == 0) {
+            opts->stream = 1;
+        } else if (strncmp(arg, "--schedule=", 11) == 0) {
+            if (parse_schedule(arg + 11, &opts->schedule) != 0) {
+                fprintf(stderr, "Некоректний розклад: %s\n", arg);
+                return -1;
+            }
+        } else if (strncmp(arg, "--threads=", 10) == 0) {
+            opts->threads = atoi(arg + 10);
+            if (opts->threads < 1) {
+                fprintf(stderr, "Некоректна кількість потоків: %s\n", arg);
+                return -1;
+            }
+        } else if (strncmp(arg, "--tile-rows=", 12) == 0) {
+            opts->tile_rows = atoi(arg + 12);
+            if (opts->tile_rows < 1) {
+                fprintf(stderr, "Некоректна висота задачі: %s\n", arg);
+                return -1;
+            }
+        } else if (strncmp(arg, "--layout=", 9) == 0) {
+            const char *name = arg + 9;
+            size_t len = strcspn(name, ",");
+            if (len == 3 && strncmp(name, "row", 3) == 0) opts->layout = LAYOUT_ROW;
+            else if (len == 5 && strncmp(name, "tiled", 5) == 0) opts->layout = LAYOUT_TILED;
+            else if (len == 6 && strncmp(name, "morton", 6) == 0) opts->layout = LAYOUT_MORTON;
+            else {
+                fprintf(stderr, "Невідома розкладка: %s\n", name);
+                return -1;
+            }
+            if (name[len] == ',') {
+                opts->layout_tile = atoi(name + len + 1);
+                if (opts->layout_tile < 1) {
+                    fprintf(stderr, "Некоректна сторона плитки: %s\n", arg);
+                    return -1;
+                }
+            }
+        } else if (strcmp(arg, "--preview") == 0) {
+            opts->preview = 1.0;
+        } else if (strncmp(arg, "--preview=", 10) == 0) {
+            opts->preview = atof(arg + 10);
+            if (opts->preview <= 0.0) {
+                fprintf(stderr, "Некоректний бюджет: %s\n", arg);
+                return -1;
+            }
+        } else if (strncmp(arg, "--preview-eps=", 14) == 0) {
+            opts->preview_eps = atof(arg + 14);
+            if (opts->preview_eps < 0.0) {
+                fprintf(stderr, "Некоректна точність: %s\n", arg);
+                return -1;
+            }
+            if (opts->preview == 0.0) opts->preview = 1.0;
+        } else if (strncmp(arg, "--output=", 9) == 0 || strncmp(arg, "--extend=", 9) == 0) {
+            const char *path = arg + 9;
+            if (*path == '\0') {
+                fprintf(stderr, "Порожній шлях: %s\n", arg);
+                return -1;
+            }
+            if (arg[2] == 'o') opts->output = path;
+            else opts->extend = path;
+        } else if (strncmp(arg, "--exponents=", 12) == 0) {
+            const char *p = arg + 12;
+            opts->exponent_count = 0;
+            while (*p) {
+                char *end;
+                ull e = strtoull(p, &end, 10);
+                if (end == p || e == 0 || (*end != ',' && *end != '\0') ||
+                    opts->exponent_count == MULTI_EXP_MAX) {
+                    fprintf(stderr, "Некоректний список експонент (до %d додатних чисел): %s\n",
+                            MULTI_EXP_MAX, arg);
+                    return -1;
+                }
+                opts->exponents[opts->exponent_count++] = e;
+                p = *end ? end + 1 : end;
+            }
+            if (opts->exponent_count == 0) {
+                fprintf(stderr, "Порожній список експонент: %s\n", arg);
+                return -1;
+            }
+        } else if (strcmp(arg, "--checksum") == 0) {
+            opts->checksum = 1;
+        } else if (strncmp(arg, "--golden=", 9) == 0) {
+            opts->golden = arg + 9;
+            opts->checksum = 1;
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (opts->exponent_count && (opts->verify || opts->e || opts->golden || opts->layout != LAYOUT_ROW)) {
+        fprintf(stderr, "--exponents несумісний з --verify, --e, --golden та плитковою розкладкою\n");
+        return -1;
+    }
+    if (opts->preview > 0.0 && (opts->verify || opts->exponent_count || opts->golden)) {
+        fprintf(stderr, "--preview несумісний з --verify, --exponents та --golden\n");
+        return -1;
+    }
+    if ((opts->output || opts->extend) && (opts->exponent_count || opts->preview > 0.0)) {
+        fprintf(stderr, "--output та --extend несумісні з --exponents і --preview\n");
+        return -1;
+    }
+    if (opts->extend && (opts->verify || opts->layout != LAYOUT_ROW)) {
+        fprintf(stderr, "--extend несумісний з --verify та плитковою розкладкою\n");
+        return -1;
+    }
+    return 0;
+}
+
+int options_setup(const grid_options *opts, ull n, ull e, rsa_key *key, modexp_plan *plan) {
+    if (!opts->verify) {
+        if (opts->e) e = opts->e;
+        if (modexp_plan_init(plan, opts->kernel, n, e) != 0) return -1;
+        plan->ilp = opts->ilp;
+        plan->stream = opts->stream;
+        return 0;
+    }
+
+    int rc = opts->key_p == 0
+                 ? rsa_key_default(key)
+                 : rsa_key_init(key, opts->key_p, opts->key_q, opts->key_e, opts->key_d);
+    if (rc != 0) return rc;
+    // Стандартне ядро переповнюється на справжньому ключі
+    grid_kernel kernel = opts->kernel == KERNEL_AUTO ? KERNEL_U128 : opts->kernel;
+    if (modexp_plan_init(plan, kernel, key->n, key->e) != 0) return -1;
+    plan->ilp = opts->ilp;
+    plan->stream = opts->stream;
+    return 0;
+}
+
+ull grid_col_step(const grid_options *opts, grid_formula fallback, int width) {
+    grid_formula formula = opts->formula == FORMULA_DEFAULT ? fallback : opts->formula;
+    return formula == FORMULA_ROW ? 1 : (ull) width;
+}
@@ -0,0 +1,88 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "rsa.h"
+#include "gridlayout.h"
+#include "preview.h"
+
+// Формула повідомлення клітинки (i, j): i * width + j * col_step
+typedef enum {
+    FORMULA_DEFAULT,    // як у драйвері
+    FORMULA_ROW,        // i * width + j, як у seq.c
+    FORMULA_DIAG,       // (i + j) * width, як у openmp.c та mpi.c
+} grid_formula;
+
+// Розміщення сітки в пам'яті NUMA (openmp.c)
+typedef enum {
+    NUMA_OFF,
+    NUMA_TOUCH,         // паралельне перше торкання блоками рядків, як у циклі обчислення
+    NUMA_BIND,          // те саме плюс явна прив'язка сторінок до вузла потоку (libnuma)
+} grid_numa;
+
+// Розподіл рядків між потоками OpenMP (openmp.c)
+typedef enum {
+    SCHED_DEFAULT,      // dynamic з порцією в один рядок, як раніше
+    SCHED_STATIC,
+    SCHED_DYNAMIC,
+    SCHED_GUIDED,
+    SCHED_TILES,        // двовимірні плитки через taskloop
+    SCHED_AUTO,         // виміряти варіанти на частині сітки і взяти найшвидший
+} grid_sched;
+
+typedef struct {
+    grid_sched kind;
+    int chunk;                  // рядків у порції; 0 — за замовчуванням OpenMP
+    int tile_rows, tile_cols;   // для SCHED_TILES
+} grid_schedule;
+
+// Параметри командного рядка, спільні для всіх драйверів
+typedef struct {
+    int verify;                 // --verify: зашифрувати справжнім ключем і перевірити розшифруванням
+    grid_kernel kernel;         // --kernel=legacy|u128|ct|barrett|mont
+    int ilp;                    // --ilp=N: незалежних ланцюжків modexp на потік
+    ull key_p, key_q, key_e;    // --key=p,q,e[,d]; нулі означають ключ за замовчуванням
+    ull key_d;
+    int width, height;          // --size=WxH; нулі — розмір драйвера
+    ull e;                      // --e=N: експонента замість e_const драйвера (без --verify)
+    grid_formula formula;       // --formula=row|diag
+    int summary;                // --summary: рядок RESULT для bench_scaling
+    int checksum;               // --checksum: відбиток усієї сітки
+    const char *golden;         // --golden=HEX: еталонний відбиток (вмикає --checksum)
+    double progress;            // --progress[=SEC]: інтервал телеметрії, 0 — вимкнено
+    const char *progress_file;  // --progress-file=PATH: Prometheus-файл замість stderr
+    const char *trace;          // --trace=PATH: часова шкала у форматі Chrome trace JSON
+    int timing;                 // --timing: таблиця часу за фазами
+    const char *timing_json;    // --timing-json=PATH: те саме у JSON ("-" — stdout)
+    int perf;                   // --perf: апаратні лічильники perf_event_open навколо обчислення
+    int energy;                 // --energy: енергія RAPL за фазами і на мільйон клітинок
+    grid_numa numa;             // --numa[=touch|bind]
+    int pin;                    // --pin: прив'язати потоки до CPU і надрукувати розміщення
+    grid_pages pages;           // --hugepages[=thp|hugetlb]: сторінки буферів сітки
+    int stream;                 // --stream: писати сітку потоковими записами повз кеш
+    grid_schedule schedule;     // --schedule=KIND[,CHUNK], --schedule=tiles[,RxC], --schedule=auto
+    int threads;                // --threads=N: виконавців пулу pthreads; 0 — за кількістю CPU
+    int tile_rows;              // --tile-rows=N: рядків у задачі пулу pthreads; 0 — за замовчуванням
+    grid_layout_kind layout;    // --layout=row|tiled|morton[,T]
+    int layout_tile;            // сторона плитки розкладки; 0 — LAYOUT_TILE_DEFAULT
+    ull exponents[MULTI_EXP_MAX];   // --exponents=E1,E2,...: сітка на кожну експоненту
+    int exponent_count;             // 0 — звичайний режим з однією експонентою
+    double preview;             // --preview[=SEC]: бюджет вибіркової оцінки, 0 — повний прогін
+    double preview_eps;         // --preview-eps=X: відносна точність середнього для зупинки
+    const char *output;         // --output=PATH: записати сітку у файл результату
+    const char *extend;         // --extend=PATH: дорахувати сітку з файлу до --size
+} grid_options;
+
+// Повертає 0 або -1 з повідомленням у stderr
+int parse_options(int argc, char *argv[], grid_options *opts);
+
+// Готує ядро для сітки: у режимі перевірки — з ключем з --key (або ключем
+// за замовчуванням), інакше — з модулем і експонентою драйвера.
+int options_setup(const grid_options *opts, ull n, ull e, rsa_key *key, modexp_plan *plan);
+
+// "dynamic,1", "tiles,16x512" тощо
+void grid_schedule_format(const grid_schedule *s, char *out, size_t size);
+
+// Крок повідомлення вздовж рядка; fallback — формула драйвера за замовчуванням
+ull grid_col_step(const grid_options *opts, grid_formula fallback, int width);
+
+#endif
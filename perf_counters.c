@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+#include "perf_counters.h"
+
+static const char *perf_names[PERF_EVENTS] = {
+    "cycles", "instructions", "branch-misses", "LLC-misses", "div-busy",
+};
+
+// Сира подія зайнятості дільника або 0, якщо для процесора вона невідома:
+// AMD Zen (family >= 0x17) — PMCx0D3 DivCycleBusyCount,
+// Intel — ARITH.DIVIDER_ACTIVE (event 0x14, umask 0x01, cmask 1)
+static unsigned long long div_busy_config(void) {
+#if defined(__x86_64__)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) return 0;
+    char vendor[13];
+    memcpy(vendor, &ebx, 4);
+    memcpy(vendor + 4, &edx, 4);
+    memcpy(vendor + 8, &ecx, 4);
+    vendor[12] = '\0';
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    unsigned int family = (eax >> 8) & 0xf;
+    if (family == 0xf) family += (eax >> 20) & 0xff;
+    if (strcmp(vendor, "AuthenticAMD") == 0 && family >= 0x17) return 0xD3;
+    if (strcmp(vendor, "GenuineIntel") == 0 && family == 6) return 0x0114 | (1ULL << 24);
+#endif
+    return 0;
+}
+
+static int open_event(unsigned int type, unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void perf_clear(perf_counters *pc) {
+    memset(pc, 0, sizeof(*pc));
+    for (int k = 0; k < PERF_EVENTS; k++) {
+        pc->fd[k] = -1;
+        pc->value[k] = -1;
+    }
+}
+
+int perf_open(perf_counters *pc) {
+    perf_clear(pc);
+    pc->fd[PERF_CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    pc->fd[PERF_INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    pc->fd[PERF_BRANCH_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    pc->fd[PERF_LLC_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    unsigned long long div = div_busy_config();
+    pc->fd[PERF_DIV_BUSY] = div ? open_event(PERF_TYPE_RAW, div) : -1;
+
+    int available = 0;
+    for (int k = 0; k < PERF_EVENTS; k++)
+        if (pc->fd[k] >= 0) available++;
+    return available;
+}
+
+void perf_begin(perf_counters *pc) {
+    for (int k = 0; k < PERF_EVENTS; k++) {
+        if (pc->fd[k] < 0) continue;
+        ioctl(pc->fd[k], PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fd[k], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void perf_end(perf_counters *pc, long long cells) {
+    for (int k = 0; k < PERF_EVENTS; k++)
+        if (pc->fd[k] >= 0) ioctl(pc->fd[k], PERF_EVENT_IOC_DISABLE, 0);
+
+    pc->cells = cells;
+    for (int k = 0; k < PERF_EVENTS; k++) {
+        unsigned long long buf[3];     // значення, час увімкнення, час роботи
+        pc->value[k] = -1;
+        if (pc->fd[k] < 0 || read(pc->fd[k], buf, sizeof(buf)) != sizeof(buf) || buf[2] == 0)
+            continue;
+        // Якщо подій більше, ніж лічильників PMU, ядро їх чергує
+        pc->value[k] = buf[2] < buf[1]
+                           ? (long long) ((double) buf[0] * buf[1] / buf[2])
+                           : (long long) buf[0];
+    }
+}
+
+void perf_close(perf_counters *pc) {
+    for (int k = 0; k < PERF_EVENTS; k++) {
+        if (pc->fd[k] >= 0) close(pc->fd[k]);
+        pc->fd[k] = -1;
+    }
+}
+
+static void print_row(const char *label, int index, const long long *v, long long cells) {
+    if (index >= 0) printf("%s %2d:", label, index);
+    else printf("Разом:");
+    for (int k = 0; k < PERF_EVENTS; k++) {
+        if (v[k] < 0) printf(" %s н/д,", perf_names[k]);
+        else printf(" %s %lld,", perf_names[k], v[k]);
+    }
+    if (v[PERF_CYCLES] > 0 && v[PERF_INSTRUCTIONS] >= 0)
+        printf(" IPC %.2f,", (double) v[PERF_INSTRUCTIONS] / v[PERF_CYCLES]);
+    else
+        printf(" IPC н/д,");
+    if (v[PERF_CYCLES] > 0 && v[PERF_DIV_BUSY] >= 0)
+        printf(" дільник зайнятий %.1f%% циклів,", 100.0 * v[PERF_DIV_BUSY] / v[PERF_CYCLES]);
+    if (v[PERF_CYCLES] >= 0 && cells > 0)
+        printf(" циклів на modexp %.1f\n", (double) v[PERF_CYCLES] / cells);
+    else
+        printf(" циклів на modexp н/д\n");
+}
+
+void perf_report(const perf_counters *pcs, int count, const char *label) {
+    long long total[PERF_EVENTS], cells = 0;
+    for (int k = 0; k < PERF_EVENTS; k++) total[k] = 0;
+
+    for (int t = 0; t < count; t++) {
+        print_row(label, t, pcs[t].value, pcs[t].cells);
+        cells += pcs[t].cells;
+        // Сума має сенс, лише якщо подія є в усіх виконавців
+        for (int k = 0; k < PERF_EVENTS; k++)
+            total[k] = (total[k] < 0 || pcs[t].value[k] < 0) ? -1 : total[k] + pcs[t].value[k];
+    }
+    if (count > 1) print_row(label, -1, total, cells);
+}
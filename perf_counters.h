@@ -0,0 +1,46 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include "thread_stats.h"
+
+// Апаратні лічильники одного потоку через perf_event_open. Кожна подія —
+// окремий дескриптор, а не група: якщо PMU не має вільного лічильника чи
+// подія не підтримується, пропадає лише вона, а не всі разом.
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_LLC_MISSES,
+    PERF_DIV_BUSY,          // цикли зайнятості дільника; сира подія, лише AMD Zen та Intel
+    PERF_EVENTS
+} perf_event_id;
+
+typedef struct {
+    int fd[PERF_EVENTS];            // -1 — подія недоступна
+    long long value[PERF_EVENTS];   // -1 — значення немає
+    long long cells;                // клітинок (modexp) за час вимірювання
+} __attribute__((aligned(CACHE_LINE))) perf_counters;
+
+// Усі дескриптори -1: для виконавців, які не відкривали лічильників
+void perf_clear(perf_counters *pc);
+
+// Відкриває лічильники для потоку, що викликає. Повертає кількість
+// доступних подій; 0 означає, що perf_event_open недоступний зовсім.
+int perf_open(perf_counters *pc);
+
+// Обнулити й увімкнути
+void perf_begin(perf_counters *pc);
+
+// Вимкнути й прочитати, з поправкою на мультиплексування лічильників
+void perf_end(perf_counters *pc, long long cells);
+
+void perf_close(perf_counters *pc);
+
+#define PERF_UNAVAILABLE_MSG \
+    "perf_event_open недоступний (див. kernel.perf_event_paranoid), лічильники не зібрано\n"
+
+// Рядок на виконавця (label — "Потік" чи "Процес") та сума: IPC, частка
+// зайнятості дільника і циклів на modexp
+void perf_report(const perf_counters *pcs, int count, const char *label);
+
+#endif
@@ -0,0 +1,79 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+#include "placement.h"
+
+int placement_cpus(int *cpus, int max) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return -1;
+    int count = 0;
+    for (int c = 0; c < CPU_SETSIZE && count < max; c++)
+        if (CPU_ISSET(c, &set)) cpus[count++] = c;
+    return count;
+}
+
+int placement_pin(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+void placement_current(int *cpu, int *node) {
+    unsigned int c, n;
+    if (getcpu(&c, &n) != 0) {
+        *cpu = sched_getcpu();
+        *node = -1;
+        return;
+    }
+    *cpu = (int) c;
+    *node = (int) n;
+}
+
+int placement_has_libnuma(void) {
+#ifdef HAVE_LIBNUMA
+    return numa_available() >= 0;
+#else
+    return 0;
+#endif
+}
+
+int placement_bind(void *ptr, size_t len, int node) {
+#ifdef HAVE_LIBNUMA
+    uintptr_t page = (uintptr_t) sysconf(_SC_PAGESIZE);
+    uintptr_t begin = ((uintptr_t) ptr + page - 1) & ~(page - 1);
+    uintptr_t end = ((uintptr_t) ptr + len + page - 1) & ~(page - 1);
+    if (end <= begin) return 0;
+    numa_tonode_memory((void *) begin, end - begin, node);
+    return 0;
+#else
+    (void) ptr;
+    (void) len;
+    (void) node;
+    return -1;
+#endif
+}
+
+void placement_report(const thread_placement *places, int count) {
+    int nodes_seen = 0;
+    unsigned long long node_mask = 0;
+    for (int t = 0; t < count; t++) {
+        const thread_placement *p = &places[t];
+        printf("Розміщення потоку %2d: CPU %d, вузол %d%s", t, p->cpu, p->node,
+               p->pinned ? ", прив'язаний" : "");
+        if (p->row_end > p->row_begin)
+            printf(", рядки %d..%d", p->row_begin, p->row_end - 1);
+        printf("\n");
+        if (p->node >= 0 && p->node < 64 && !(node_mask & (1ULL << p->node))) {
+            node_mask |= 1ULL << p->node;
+            nodes_seen++;
+        }
+    }
+    printf("Потоків: %d, вузлів NUMA задіяно: %d\n", count, nodes_seen);
+}
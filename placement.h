@@ -0,0 +1,43 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stddef.h>
+#include "thread_stats.h"
+
+// Де опинився потік і які рядки сітки він першим торкнувся
+typedef struct {
+    int cpu;
+    int node;               // вузол NUMA, -1 — невідомо
+    int row_begin, row_end; // [row_begin, row_end), порожньо без --numa
+    int pinned;
+} __attribute__((aligned(CACHE_LINE))) thread_placement;
+
+// Рядки потоку t при детермінованому розподілі блоками по rows_per_thread:
+// так само OpenMP роздає schedule(static, rows_per_thread)
+static inline int placement_rows_per_thread(int height, int threads) {
+    return (height + threads - 1) / threads;
+}
+
+#define PLACEMENT_MAX_CPUS 1024
+
+// CPU з маски спорідненості процесу, у порядку номерів. Викликати з
+// основного потоку до прив'язування. Повертає кількість або -1.
+int placement_cpus(int *cpus, int max);
+
+// Прив'язує потік, що викликає, до одного CPU. Повертає 0 або -1.
+int placement_pin(int cpu);
+
+// Поточні CPU і вузол потоку, що викликає
+void placement_current(int *cpu, int *node);
+
+// 1, якщо зібрано з libnuma і ядро підтримує NUMA
+int placement_has_libnuma(void);
+
+// Прив'язує сторінки, що починаються в [ptr, ptr + len), до вузла node
+// (libnuma); сторінка належить тому діапазону, де її перший байт.
+// Повертає 0 або -1.
+int placement_bind(void *ptr, size_t len, int node);
+
+void placement_report(const thread_placement *places, int count);
+
+#endif
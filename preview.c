@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "preview.h"
+#include "fingerprint.h"
+#include "timing.h"
+
+#define PREVIEW_Z 1.959964          // двобічні 95% нормального розподілу
+#define PREVIEW_TAIL 2.995732       // -ln(0.05): межа частки хвоста за n спробами
+
+const double preview_quantile_levels[PREVIEW_QUANTILES] = {0.01, 0.10, 0.50, 0.90, 0.99};
+
+// Прямокутник страти і накопичувачі по ній (Велфорд для дисперсії)
+typedef struct {
+    int row, rows, col, cols;
+    double cells;               // частка сітки: N_h / N
+    long count;
+    double mean, m2;
+    long bins[PREVIEW_BINS];
+} stratum;
+
+typedef struct {
+    ull value;
+    int stratum;
+    double weight;              // частка сітки, яку представляє клітинка: W_h / n_h
+} sample;
+
+typedef struct {
+    stratum *strata;
+    int count;
+    sample *samples;
+    long samples_count;
+} preview_state;
+
+static int bin_of(ull value, ull n) {
+    int b = (int) (((unsigned __int128) value * PREVIEW_BINS) / n);
+    return b < PREVIEW_BINS ? b : PREVIEW_BINS - 1;
+}
+
+// Рівномірне число в [0, bound) множенням замість ділення з остачею
+static ull uniform_below(ull *state, ull bound) {
+    *state += 0x9E3779B97F4A7C15ULL;
+    return (ull) (((unsigned __int128) fmix64(*state) * bound) >> 64);
+}
+
+static int strata_init(preview_state *st, const preview_config *cfg) {
+    int sy = cfg->height < PREVIEW_STRATA_SIDE ? cfg->height : PREVIEW_STRATA_SIDE;
+    int sx = cfg->width < PREVIEW_STRATA_SIDE ? cfg->width : PREVIEW_STRATA_SIDE;
+    st->count = sx * sy;
+    st->strata = calloc(st->count, sizeof(stratum));
+    if (!st->strata) return -1;
+    double total = (double) cfg->width * cfg->height;
+    for (int a = 0; a < sy; a++) {
+        for (int b = 0; b < sx; b++) {
+            stratum *s = &st->strata[a * sx + b];
+            s->row = (int) ((long long) a * cfg->height / sy);
+            s->rows = (int) ((long long) (a + 1) * cfg->height / sy) - s->row;
+            s->col = (int) ((long long) b * cfg->width / sx);
+            s->cols = (int) ((long long) (b + 1) * cfg->width / sx) - s->col;
+            s->cells = (double) s->rows * s->cols / total;
+        }
+    }
+    return 0;
+}
+
+// Стратифікована оцінка середнього: sum W_h * mean_h, дисперсія sum W_h^2 s_h^2 / n_h
+static void estimate_mean(const preview_state *st, double *mean, double *half) {
+    double m = 0.0, var = 0.0;
+    for (int h = 0; h < st->count; h++) {
+        const stratum *s = &st->strata[h];
+        m += s->cells * s->mean;
+        if (s->count > 1) var += s->cells * s->cells * (s->m2 / (s->count - 1)) / s->count;
+    }
+    *mean = m;
+    *half = PREVIEW_Z * sqrt(var);
+}
+
+static int cmp_sample(const void *a, const void *b) {
+    ull x = ((const sample *) a)->value, y = ((const sample *) b)->value;
+    return (x > y) - (x < y);
+}
+
+// Значення, на якому зважена частка вибірки досягає p
+static ull quantile_at(const sample *sorted, long count, double p) {
+    double acc = 0.0;
+    for (long k = 0; k < count; k++) {
+        acc += sorted[k].weight;
+        if (acc >= p) return sorted[k].value;
+    }
+    return sorted[count - 1].value;
+}
+
+static void estimate_all(preview_state *st, const preview_config *cfg, preview_result *res) {
+    estimate_mean(st, &res->mean, &res->mean_half);
+    for (long k = 0; k < st->samples_count; k++) {
+        sample *x = &st->samples[k];
+        x->weight = st->strata[x->stratum].cells / st->strata[x->stratum].count;
+        if (k == 0 || x->value < res->min) res->min = x->value;
+        if (k == 0 || x->value > res->max) res->max = x->value;
+    }
+    res->tail_cells = PREVIEW_TAIL / st->samples_count * cfg->width * cfg->height;
+
+    // Гістограма: частка кошика по стратах, дисперсія sum W_h^2 p_h (1 - p_h) / n_h
+    for (int b = 0; b < PREVIEW_BINS; b++) {
+        double p = 0.0, var = 0.0;
+        for (int h = 0; h < st->count; h++) {
+            const stratum *s = &st->strata[h];
+            double ph = (double) s->bins[b] / s->count;
+            p += s->cells * ph;
+            var += s->cells * s->cells * ph * (1.0 - ph) / s->count;
+        }
+        res->bin_share[b] = p;
+        res->bin_half[b] = PREVIEW_Z * sqrt(var);
+    }
+
+    // Інтервал квантиля — ранги p -+ z sqrt(p (1 - p) / n) без поправки на
+    // стратифікацію, яка лише зменшує дисперсію, тож інтервал консервативний
+    qsort(st->samples, st->samples_count, sizeof(sample), cmp_sample);
+    for (int q = 0; q < PREVIEW_QUANTILES; q++) {
+        double p = preview_quantile_levels[q];
+        double delta = PREVIEW_Z * sqrt(p * (1.0 - p) / st->samples_count);
+        res->quantile[q] = quantile_at(st->samples, st->samples_count, p);
+        res->quantile_lo[q] = quantile_at(st->samples, st->samples_count, p - delta > 0.0 ? p - delta : 0.0);
+        res->quantile_hi[q] = quantile_at(st->samples, st->samples_count, p + delta < 1.0 ? p + delta : 1.0);
+    }
+}
+
+int preview_run(const preview_config *cfg, preview_encrypt_fn encrypt, preview_agree_fn agree,
+                void *ctx, preview_result *res) {
+    preview_state st = {0};
+    if (strata_init(&st, cfg) != 0) return -1;
+    long cells = (long) ((long long) cfg->width * cfg->height < PREVIEW_MAX_SAMPLES
+                         ? (long long) cfg->width * cfg->height : PREVIEW_MAX_SAMPLES);
+
+    ull *messages = NULL, *out = NULL;
+    int *origin = NULL;
+    long capacity = 0;
+    double start = wall_now();
+    int rc = 0;
+    res->rounds = 0;
+
+    for (int round = 0;; round++) {
+        long per_stratum = (long) PREVIEW_FIRST_ROUND << round;
+        long batch = per_stratum * st.count;
+        if (st.samples_count + batch > cells) break;
+        if (st.samples_count + batch > capacity) {
+            capacity = st.samples_count + batch;
+            sample *grown = realloc(st.samples, capacity * sizeof(sample));
+            if (grown) st.samples = grown;
+            free(messages);
+            free(out);
+            free(origin);
+            messages = malloc(batch * sizeof(ull));
+            out = malloc(batch * sizeof(ull));
+            origin = malloc(batch * sizeof(int));
+            if (!grown || !messages || !out || !origin) {
+                rc = -1;
+                break;
+            }
+        }
+
+        double round_begin = wall_now();
+        // Клітинки раунду однакові в усіх процесів: генератор залежить лише від seed, раунду і страти
+        long k = 0;
+        for (int h = 0; h < st.count; h++) {
+            const stratum *s = &st.strata[h];
+            ull state = fmix64(cfg->seed ^ ((ull) round << 32) ^ (ull) h);
+            for (long c = 0; c < per_stratum; c++, k++) {
+                ull i = s->row + uniform_below(&state, s->rows);
+                ull j = s->col + uniform_below(&state, s->cols);
+                messages[k] = i * cfg->width + j * cfg->col_step;
+                origin[k] = h;
+            }
+        }
+        encrypt(ctx, messages, out, batch);
+
+        for (k = 0; k < batch; k++) {
+            stratum *s = &st.strata[origin[k]];
+            double x = (double) out[k];
+            s->count++;
+            double delta = x - s->mean;
+            s->mean += delta / s->count;
+            s->m2 += delta * (x - s->mean);
+            s->bins[bin_of(out[k], cfg->n)]++;
+        }
+        for (k = 0; k < batch; k++) st.samples[st.samples_count + k] = (sample) {out[k], origin[k], 0.0};
+        st.samples_count += batch;
+        res->rounds = round + 1;
+
+        // Наступний раунд удвічі більший: зупинка, якщо він не вміститься в бюджет
+        double now = wall_now();
+        double mean, half;
+        estimate_mean(&st, &mean, &half);
+        int stop = now - start + 2.0 * (now - round_begin) > cfg->budget ||
+                   (cfg->eps > 0.0 && mean > 0.0 && half / mean <= cfg->eps);
+        if (agree) stop = agree(ctx, stop);
+        if (stop) break;
+    }
+
+    if (rc == 0 && st.samples_count == 0) {
+        fprintf(stderr, "Сітка замала для вибірки, потрібен повний прогін\n");
+        rc = -1;
+    }
+    if (rc == 0) {
+        res->samples = st.samples_count;
+        estimate_all(&st, cfg, res);
+        res->seconds = wall_now() - start;
+    }
+    free(messages);
+    free(out);
+    free(origin);
+    free(st.samples);
+    free(st.strata);
+    return rc;
+}
+
+void preview_report(const preview_config *cfg, const preview_result *res,
+                    const char *backend, int workers, int summary) {
+    double cells = (double) cfg->width * cfg->height;
+    printf("Попередній перегляд %dx%d (%s, %d): %ld клітинок (%.3f%% сітки) за %d раундів, %.3f с\n",
+           cfg->width, cfg->height, backend, workers, res->samples, 100.0 * res->samples / cells,
+           res->rounds, res->seconds);
+    printf("Середнє: %.6e +- %.3e (95%%, відносна похибка %.4f%%)\n",
+           res->mean, res->mean_half, res->mean > 0.0 ? 100.0 * res->mean_half / res->mean : 0.0);
+    printf("min <= %llu, max >= %llu; за кожною межею щонайбільше ~%.0f клітинок (95%%)\n",
+           res->min, res->max, res->tail_cells);
+    printf("%-8s %22s %22s %22s\n", "quantile", "estimate", "lo95", "hi95");
+    for (int q = 0; q < PREVIEW_QUANTILES; q++)
+        printf("p%-7.0f %22llu %22llu %22llu\n", 100.0 * preview_quantile_levels[q],
+               res->quantile[q], res->quantile_lo[q], res->quantile_hi[q]);
+    printf("%-4s %22s %9s %9s %14s\n", "bin", "from", "share%", "+-95%", "cells");
+    for (int b = 0; b < PREVIEW_BINS; b++)
+        printf("%-4d %22llu %9.3f %9.3f %14.0f\n", b,
+               (ull) (((unsigned __int128) cfg->n * b) / PREVIEW_BINS),
+               100.0 * res->bin_share[b], 100.0 * res->bin_half[b], res->bin_share[b] * cells);
+    printf("Точні значення дає лише повний прогін без --preview\n");
+
+    if (summary) {
+        printf("PREVIEW backend=%s workers=%d width=%d height=%d samples=%ld rounds=%d seconds=%.6f "
+               "mean=%.6e mean_half=%.6e min=%llu max=%llu",
+               backend, workers, cfg->width, cfg->height, res->samples, res->rounds, res->seconds,
+               res->mean, res->mean_half, res->min, res->max);
+        for (int q = 0; q < PREVIEW_QUANTILES; q++)
+            printf(" p%.0f=%llu", 100.0 * preview_quantile_levels[q], res->quantile[q]);
+        printf("\n");
+    }
+}
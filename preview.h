@@ -0,0 +1,60 @@
+#ifndef PREVIEW_H
+#define PREVIEW_H
+
+#include "kernels.h"
+
+// Швидкий попередній перегляд статистик сітки (--preview): замість усіх
+// клітинок шифрується стратифікована випадкова вибірка. Сітка ділиться на
+// PREVIEW_STRATA_SIDE x PREVIEW_STRATA_SIDE прямокутників, у кожному раунді з
+// кожного береться однакова кількість випадкових клітинок, і раунди
+// подвоюються, доки не вичерпано бюджет часу або не досягнуто точності.
+// Оцінки — середнє, квантилі й гістограма з 95% інтервалами, а для min/max —
+// вибіркові крайні значення з межею частки клітинок за ними.
+
+#define PREVIEW_STRATA_SIDE 16
+#define PREVIEW_FIRST_ROUND 4       // клітинок на страту в першому раунді
+#define PREVIEW_MAX_SAMPLES (1L << 24)
+#define PREVIEW_BINS 16
+#define PREVIEW_QUANTILES 5         // 1%, 10%, 50%, 90%, 99%
+#define PREVIEW_BLOCK 1024          // повідомлень у задачі паралельного шифрування
+#define PREVIEW_EPS_DEFAULT 0.001
+#define PREVIEW_SEED 0x5EED5EED5EED5EEDULL
+
+// Шифрує count повідомлень; бекенд ділить їх між своїми потоками чи процесами
+typedef void (*preview_encrypt_fn)(void *ctx, const ull *messages, ull *out, long count);
+
+// Узгоджує рішення зупинитися між процесами (MPI: рішення процесу 0);
+// NULL — рішення локальне
+typedef int (*preview_agree_fn)(void *ctx, int stop);
+
+typedef struct {
+    int width, height;
+    ull col_step;               // повідомлення клітинки (i, j) — i * width + j * col_step
+    ull n;                      // модуль: шифротексти лежать у [0, n)
+    double budget;              // бюджет часу, секунд
+    double eps;                 // ціль: відносна півширина інтервалу середнього; 0 — лише бюджет
+    ull seed;                   // однаковий у всіх процесів
+} preview_config;
+
+typedef struct {
+    long samples;
+    int rounds;
+    double seconds;
+    double mean, mean_half;     // середнє та півширина 95% інтервалу
+    ull min, max;               // вибіркові крайні значення
+    double tail_cells;          // за межами [min, max] — щонайбільше стільки клітинок з кожного боку (95%)
+    ull quantile[PREVIEW_QUANTILES], quantile_lo[PREVIEW_QUANTILES], quantile_hi[PREVIEW_QUANTILES];
+    double bin_share[PREVIEW_BINS], bin_half[PREVIEW_BINS];
+} preview_result;
+
+extern const double preview_quantile_levels[PREVIEW_QUANTILES];
+
+// Повертає 0 або -1 при помилці виділення пам'яті
+int preview_run(const preview_config *cfg, preview_encrypt_fn encrypt, preview_agree_fn agree,
+                void *ctx, preview_result *res);
+
+// Звіт у stdout; із summary — ще рядок "PREVIEW key=value ..."
+void preview_report(const preview_config *cfg, const preview_result *res,
+                    const char *backend, int workers, int summary);
+
+#endif
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "progress.h"
+#include "timing.h"
+
+int progress_init(progress_monitor *mon, const char *backend, int workers,
+                  long long total_rows, int width, double interval, const char *path) {
+    memset(mon, 0, sizeof(*mon));
+    mon->slots = aligned_alloc(CACHE_LINE, workers * sizeof(progress_slot));
+    mon->last_rows = calloc(workers, sizeof(long long));
+    if (!mon->slots || !mon->last_rows) {
+        progress_free(mon);
+        return -1;
+    }
+    for (int w = 0; w < workers; w++) atomic_init(&mon->slots[w].rows, 0);
+    mon->backend = backend;
+    mon->workers = workers;
+    mon->total_rows = total_rows;
+    mon->width = width;
+    mon->interval = interval;
+    mon->path = path;
+    mon->emit = 1;
+    atomic_init(&mon->stop, 0);
+    return 0;
+}
+
+// Одна вибірка у форматі Prometheus exposition
+static void write_sample(progress_monitor *mon, FILE *out, double now) {
+    double dt = now - mon->last_time;
+    long long done = 0;
+    const char *b = mon->backend;
+
+    fprintf(out, "# HELP rsagrid_rows_done Готові рядки виконавця\n"
+                 "# TYPE rsagrid_rows_done counter\n");
+    for (int w = 0; w < mon->workers; w++) {
+        long long rows = atomic_load_explicit(&mon->slots[w].rows, memory_order_relaxed);
+        done += rows;
+        fprintf(out, "rsagrid_rows_done{backend=\"%s\",worker=\"%d\"} %lld\n", b, w, rows);
+    }
+    fprintf(out, "# HELP rsagrid_worker_cells_per_second Швидкість виконавця з попередньої вибірки\n"
+                 "# TYPE rsagrid_worker_cells_per_second gauge\n");
+    long long last_done = 0;
+    for (int w = 0; w < mon->workers; w++) {
+        long long rows = atomic_load_explicit(&mon->slots[w].rows, memory_order_relaxed);
+        double rate = dt > 0.0 ? (double) (rows - mon->last_rows[w]) * mon->width / dt : 0.0;
+        fprintf(out, "rsagrid_worker_cells_per_second{backend=\"%s\",worker=\"%d\"} %.0f\n", b, w, rate);
+        last_done += mon->last_rows[w];
+        mon->last_rows[w] = rows;
+    }
+
+    double elapsed = now - mon->start_time;
+    double cells = (double) done * mon->width;
+    double total = (double) mon->total_rows * mon->width;
+    double rate = dt > 0.0 ? (double) (done - last_done) * mon->width / dt : 0.0;
+    double mean_rate = elapsed > 0.0 ? cells / elapsed : 0.0;
+    // ETA за середньою швидкістю від старту: миттєва занадто шумна
+    double eta = mean_rate > 0.0 ? (total - cells) / mean_rate : -1.0;
+
+    fprintf(out, "# TYPE rsagrid_cells_done counter\nrsagrid_cells_done{backend=\"%s\"} %.0f\n", b, cells);
+    fprintf(out, "# TYPE rsagrid_cells_total gauge\nrsagrid_cells_total{backend=\"%s\"} %.0f\n", b, total);
+    fprintf(out, "# TYPE rsagrid_cells_per_second gauge\nrsagrid_cells_per_second{backend=\"%s\"} %.0f\n", b, rate);
+    fprintf(out, "# TYPE rsagrid_elapsed_seconds gauge\nrsagrid_elapsed_seconds{backend=\"%s\"} %.3f\n", b, elapsed);
+    fprintf(out, "# TYPE rsagrid_eta_seconds gauge\nrsagrid_eta_seconds{backend=\"%s\"} %.3f\n", b, eta);
+    mon->last_time = now;
+}
+
+// Файл перезаписується через тимчасовий і rename, щоб збирач не прочитав половину
+static void emit_sample(progress_monitor *mon) {
+    double now = wall_now();
+    if (!mon->path) {
+        write_sample(mon, stderr, now);
+        fflush(stderr);
+        return;
+    }
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", mon->path);
+    FILE *out = fopen(tmp, "w");
+    if (!out) return;
+    write_sample(mon, out, now);
+    fclose(out);
+    rename(tmp, mon->path);
+}
+
+static void *monitor_main(void *arg) {
+    progress_monitor *mon = arg;
+    // Короткі кроки сну, щоб зупинка не чекала повного інтервалу
+    const double step = 0.05;
+    double next = mon->start_time + mon->interval;
+    while (!atomic_load_explicit(&mon->stop, memory_order_acquire)) {
+        struct timespec ts = {0, (long) (step * 1e9)};
+        nanosleep(&ts, NULL);
+        double now = wall_now();
+        if (now >= next) {
+            if (mon->hook) mon->hook(mon, 0);
+            if (mon->emit) emit_sample(mon);
+            next = now + mon->interval;
+        }
+    }
+    return NULL;
+}
+
+int progress_start(progress_monitor *mon) {
+    mon->start_time = mon->last_time = wall_now();
+    mon->started = pthread_create(&mon->thread, NULL, monitor_main, mon) == 0;
+    return mon->started ? 0 : -1;
+}
+
+void progress_stop(progress_monitor *mon) {
+    atomic_store_explicit(&mon->stop, 1, memory_order_release);
+    if (mon->started) pthread_join(mon->thread, NULL);
+    mon->started = 0;
+    if (mon->hook) mon->hook(mon, 1);
+    if (mon->emit) emit_sample(mon);
+}
+
+void progress_free(progress_monitor *mon) {
+    free(mon->slots);
+    free(mon->last_rows);
+    mon->slots = NULL;
+    mon->last_rows = NULL;
+}
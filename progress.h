@@ -0,0 +1,59 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "thread_stats.h"
+
+// Лічильник готових рядків одного виконавця. Пише лише власник, тому
+// інкремент — relaxed load + store без lock-префікса; монітор лише читає.
+typedef struct {
+    _Atomic long long rows;
+} __attribute__((aligned(CACHE_LINE))) progress_slot;
+
+static inline void progress_row_done(progress_slot *slot) {
+    long long rows = atomic_load_explicit(&slot->rows, memory_order_relaxed);
+    atomic_store_explicit(&slot->rows, rows + 1, memory_order_relaxed);
+}
+
+typedef struct progress_monitor progress_monitor;
+
+// Викликається потоком монітора перед кожною вибіркою (final = 0) і один раз
+// з потоку, що викликав progress_stop (final = 1); так mpi.c збирає
+// лічильники інших процесів
+typedef void (*progress_hook)(progress_monitor *mon, int final);
+
+struct progress_monitor {
+    const char *backend;
+    progress_slot *slots;       // по одному на виконавця
+    int workers;
+    long long total_rows;
+    int width;
+    double interval;            // секунд між вибірками
+    const char *path;           // файл у форматі Prometheus або NULL для stderr
+    int emit;                   // 0 — лише викликати hook (не-root процеси MPI)
+    progress_hook hook;
+    void *hook_ctx;
+
+    atomic_int stop;
+    pthread_t thread;
+    int started;                // потік створено, progress_stop його приєднує
+    double start_time, last_time;
+    long long *last_rows;
+};
+
+// Виділяє слоти і заповнює поля; потік запускає progress_start.
+// Повертає 0 або -1.
+int progress_init(progress_monitor *mon, const char *backend, int workers,
+                  long long total_rows, int width, double interval, const char *path);
+
+// Повертає 0 або -1, якщо потік не створено; progress_stop лишається
+// безпечним і без потоку
+int progress_start(progress_monitor *mon);
+
+// Зупиняє потік (якщо він є), викликає hook(final = 1) і записує останню вибірку
+void progress_stop(progress_monitor *mon);
+
+void progress_free(progress_monitor *mon);
+
+#endif
@@ -0,0 +1,420 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "rsa.h"
+#include "options.h"
+#include "report.h"
+#include "thread_stats.h"
+#include "progress.h"
+#include "trace.h"
+#include "timing.h"
+#include "gridpool.h"
+#include "perf_counters.h"
+#include "gridfile.h"
+
+#define WIDTH 3000
+#define HEIGHT 3000
+
+const ll p_const = 3000000007LL;
+const ll q_const = 3000000011LL;
+const ll n_const = p_const * q_const;
+const ll e_const = 900000000000000LL;
+
+// Перевірка розшифруванням на тому ж пулі: задача — блок рядків
+typedef struct {
+    const modexp_plan *plan;
+    const rsa_key *key;
+    const grid_layout *layout;
+    const ull *data;
+    int width, height, tile_rows;
+    ull col_step;
+    _Atomic long long mismatches;
+} verify_ctx;
+
+static void verify_tile(void *arg, long task, int worker) {
+    verify_ctx *v = arg;
+    (void) worker;
+    int first = (int)task * v->tile_rows;
+    int last = first + v->tile_rows < v->height ? first + v->tile_rows : v->height;
+    const int ilp = v->plan->ilp;
+    ull ciphertexts[ILP_MAX], decrypted[ILP_MAX];
+    for (int i = first; i < last; i++) {
+        for (int j = 0; j < v->width; j += ilp) {
+            int count = v->width - j < ilp ? v->width - j : ilp;
+            for (int k = 0; k < count; k++) ciphertexts[k] = grid_layout_at(v->layout, v->data, i, j + k);
+            plan_decrypt_batch(v->plan, v->key, ciphertexts, decrypted, count);
+            for (int k = 0; k < count; k++) {
+                ull message = (ull)i * v->width + (j + k) * v->col_step;
+                if (decrypted[k] != message) {
+                    long long seen = atomic_fetch_add_explicit(&v->mismatches, 1, memory_order_relaxed);
+                    if (seen < VERIFY_REPORT_LIMIT)
+                        rsa_report_mismatch(i, j + k, message, ciphertexts[k], decrypted[k]);
+                }
+            }
+        }
+    }
+}
+
+// Лічильники perf рахують потік, що їх відкрив, тож кожен виконавець
+// відкриває й закриває свої через workpool_each
+typedef struct {
+    perf_counters *pc;
+    const thread_stats *stats;
+    _Atomic int available;
+} perf_ctx;
+
+static void perf_start_worker(void *arg, long task, int worker) {
+    perf_ctx *p = arg;
+    (void) task;
+    if (perf_open(&p->pc[worker]) > 0) atomic_store_explicit(&p->available, 1, memory_order_relaxed);
+    perf_begin(&p->pc[worker]);
+}
+
+static void perf_stop_worker(void *arg, long task, int worker) {
+    perf_ctx *p = arg;
+    (void) task;
+    perf_end(&p->pc[worker], p->stats[worker].cells);
+}
+
+// Вибірка --preview на пулі: задача — блок з PREVIEW_BLOCK повідомлень
+typedef struct {
+    const modexp_plan *plan;
+    workpool *pool;
+    const ull *messages;
+    ull *out;
+    long count;
+} preview_ctx;
+
+static void preview_block(void *arg, long task, int worker) {
+    preview_ctx *p = arg;
+    (void) worker;
+    long first = task * PREVIEW_BLOCK;
+    long count = p->count - first < PREVIEW_BLOCK ? p->count - first : PREVIEW_BLOCK;
+    plan_encrypt_messages(p->plan, p->messages + first, p->out + first, count);
+}
+
+static void preview_encrypt(void *ctx, const ull *messages, ull *out, long count) {
+    preview_ctx *p = ctx;
+    p->messages = messages;
+    p->out = out;
+    p->count = count;
+    workpool_run(p->pool, (count + PREVIEW_BLOCK - 1) / PREVIEW_BLOCK, preview_block, p);
+}
+
+// Режим --extend на пулі: задача — рядок блоку з EXTEND_BLOCK_ROWS рядків,
+// min/max і лічильник нових клітинок у кожного виконавця свої
+#define EXTEND_BLOCK_ROWS 64
+
+typedef struct {
+    const grid_extension *x;
+    ull *block;
+    int first;
+    ull *min, *max;
+    long long *computed;
+} extend_ctx;
+
+static void extend_row(void *arg, long task, int worker) {
+    extend_ctx *c = arg;
+    c->computed[worker] += grid_extension_row(c->x, c->first + (int)task, &c->block[(size_t)task * c->x->width],
+                                              &c->min[worker], &c->max[worker]);
+}
+
+static int run_extend(const grid_options *opts, const modexp_plan *plan, int width, int height, int workers) {
+    gridfile_map old;
+    grid_extension x;
+    gridfile_writer w;
+    ull min, max;
+    if (gridfile_open(&old, opts->extend) != 0) return 1;
+    if (grid_extension_init(&x, plan, &old, width, height) != 0 ||
+        grid_extension_begin(&x, &w, opts->output ? opts->output : opts->extend, &min, &max) != 0) {
+        gridfile_close(&old);
+        return 1;
+    }
+    workpool *pool = workpool_create(workers);
+    extend_ctx c = {&x, malloc((size_t)EXTEND_BLOCK_ROWS * width * sizeof(ull)), 0,
+                    malloc(workers * sizeof(ull)), malloc(workers * sizeof(ull)),
+                    calloc(workers, sizeof(long long))};
+    int rc = pool && c.block && c.min && c.max && c.computed ? 0 : 1;
+    if (rc != 0) fprintf(stderr, "Помилка виділення пам'яті!\n");
+    for (int k = 0; rc == 0 && k < workers; k++) {
+        c.min[k] = min;
+        c.max[k] = max;
+    }
+
+    double t0 = wall_now();
+    for (c.first = 0; rc == 0 && c.first < height; c.first += EXTEND_BLOCK_ROWS) {
+        int rows = height - c.first < EXTEND_BLOCK_ROWS ? height - c.first : EXTEND_BLOCK_ROWS;
+        workpool_run(pool, rows, extend_row, &c);
+        if (gridfile_write_rows(&w, c.block, rows) != 0) rc = 1;
+    }
+    double elapsed = wall_now() - t0;
+
+    if (rc == 0) {
+        long long computed = 0;
+        for (int k = 0; k < workers; k++) {
+            if (c.min[k] < min) min = c.min[k];
+            if (c.max[k] > max) max = c.max[k];
+            computed += c.computed[k];
+        }
+        grid_summary summary = {"pthreads", workers, width, height, grid_kernel_name(plan->kernel), plan->ilp,
+                                plan->e, x.col_step, elapsed, min, max, {0}};
+        rc = grid_extension_finish(&x, &w, opts, &summary, computed, min, max);
+    } else {
+        gridfile_abort(&w);
+    }
+    workpool_destroy(pool);
+    free(c.block);
+    free(c.min);
+    free(c.max);
+    free(c.computed);
+    gridfile_close(&old);
+    return rc;
+}
+
+int main(int argc, char *argv[]) {
+    grid_options opts;
+    rsa_key key;
+    modexp_plan plan;
+    if (parse_options(argc, argv, &opts) != 0) return 1;
+    if (options_setup(&opts, n_const, e_const, &key, &plan) != 0) return 1;
+    if (opts.exponent_count) {
+        fprintf(stderr, "--exponents підтримують лише seq та openmp\n");
+        return 1;
+    }
+
+    int width = opts.width ? opts.width : WIDTH;
+    int height = opts.height ? opts.height : HEIGHT;
+    // Повідомлення клітинки (i, j) — i * width + j * col_step, за замовчуванням (i + j) * width, як в openmp.c
+    ull col_step = grid_col_step(&opts, FORMULA_DIAG, width);
+    int workers = opts.threads ? opts.threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers < 1) workers = 1;
+    int tile_rows = opts.tile_rows ? opts.tile_rows : POOL_TILE_ROWS;
+
+    if (opts.extend) return run_extend(&opts, &plan, width, height, workers);
+    if (opts.preview > 0.0) {
+        preview_config cfg = {width, height, col_step, plan.n, opts.preview, opts.preview_eps, PREVIEW_SEED};
+        preview_ctx ctx = {&plan, workpool_create(workers), NULL, NULL, 0};
+        preview_result res;
+        int rc = ctx.pool && preview_run(&cfg, preview_encrypt, NULL, &ctx, &res) == 0 ? 0 : 1;
+        if (rc == 0) preview_report(&cfg, &res, "pthreads", workers, opts.summary);
+        else fprintf(stderr, "Помилка попереднього перегляду\n");
+        workpool_destroy(ctx.pool);
+        return rc;
+    }
+
+    phase_timer phases;
+    phase_init(&phases);
+    energy_meter energy;
+    if (opts.energy) {
+        if (energy_open(&energy, ENERGY_SYSFS) == 0) phase_attach_energy(&phases, &energy);
+        else fprintf(stderr, ENERGY_UNAVAILABLE_MSG);
+    }
+
+    // З плитковою розкладкою задача пулу — плитка, а не tile_rows рядків
+    grid_layout layout;
+    if (grid_layout_init(&layout, opts.layout, width, height, opts.layout_tile) != 0) {
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    int tiled = layout.kind != LAYOUT_ROW;
+    int units = tiled ? grid_layout_units(&layout) : height;
+
+    grid_buffer data_buf;
+    ull *data = grid_buffer_alloc(&data_buf, grid_layout_cells(&layout), opts.pages);
+    if (!data) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+
+    workpool *pool = workpool_create(workers);
+    thread_stats *stats = thread_stats_alloc(workers);
+    if (!pool || !stats) {
+        fprintf(stderr, "Помилка створення пулу потоків!\n");
+        workpool_destroy(pool);
+        free(stats);
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+
+    progress_monitor progress;
+    if (progress_init(&progress, "pthreads", workers, units, (int)((long long)width * height / units),
+                      opts.progress, opts.progress_file) != 0) {
+        fprintf(stderr, "Помилка виділення лічильників прогресу!\n");
+        workpool_destroy(pool);
+        free(stats);
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    if (opts.progress > 0.0 && progress_start(&progress) != 0)
+        fprintf(stderr, "Не вдалося запустити потік прогресу\n");
+
+    trace_log trace;
+    if (trace_init(&trace, opts.trace != NULL, workers, 0) != 0) {
+        fprintf(stderr, "Помилка виділення буфера трасування!\n");
+        if (opts.progress > 0.0) progress_stop(&progress);
+        progress_free(&progress);
+        workpool_destroy(pool);
+        free(stats);
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    // Основний потік лише чекає пул, тож його події — в окремому кільці
+    trace_log main_trace;
+    if (trace_init(&main_trace, opts.trace != NULL, 1, 0) != 0) {
+        fprintf(stderr, "Помилка виділення буфера трасування!\n");
+        trace_free(&trace);
+        if (opts.progress > 0.0) progress_stop(&progress);
+        progress_free(&progress);
+        workpool_destroy(pool);
+        free(stats);
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    trace_ring *main_ring = trace_thread(&main_trace, 0);
+
+    perf_ctx perf = {NULL, stats, 0};
+    if (opts.perf) {
+        perf.pc = aligned_alloc(CACHE_LINE, workers * sizeof(perf_counters));
+        if (!perf.pc) {
+            fprintf(stderr, "Помилка виділення лічильників perf!\n");
+            trace_free(&main_trace);
+            trace_free(&trace);
+            if (opts.progress > 0.0) progress_stop(&progress);
+            progress_free(&progress);
+            workpool_destroy(pool);
+            free(stats);
+            grid_buffer_free(&data_buf);
+            grid_layout_free(&layout);
+            if (phases.has_energy) energy_close(&energy);
+            return 1;
+        }
+        for (int w = 0; w < workers; w++) perf_clear(&perf.pc[w]);
+        workpool_each(pool, perf_start_worker, &perf);
+    }
+
+    double t0 = wall_now();
+    phase_mark_at(&phases, PHASE_ALLOC, t0);
+
+    grid_pool_job job = {&plan, data, width, height, col_step, tile_rows, opts.checksum,
+                         stats, progress.slots, &trace};
+    job.layout = &layout;
+    grid_reduction result;
+    grid_pool_encrypt(pool, &job, &result);
+
+    // Редукція вже зроблена атомарними операціями під час обчислення
+    double t1 = phase_mark(&phases, PHASE_COMPUTE);
+    ull global_min = result.min, global_max = result.max;
+    if (perf.pc) workpool_each(pool, perf_stop_worker, &perf);
+    // Зупинка монітора — завершення обчислення, не збір результату
+    if (opts.progress > 0.0) progress_stop(&progress);
+    progress_free(&progress);
+    phase_mark(&phases, PHASE_REDUCE);
+
+    printf("Згенеровано зображення %dx%d за %f секунд. min = %llu, max = %llu\n",
+           width, height, t1, global_min, global_max);
+    if (tiled)
+        printf("Пул: %d виконавців, задача — плитка %dx%d, розкладка %s\n", workers, layout.tile,
+               layout.tile, grid_layout_name(layout.kind));
+    else
+        printf("Пул: %d виконавців, задача %d рядків\n", workers, tile_rows);
+    long long steals = 0;
+    for (int w = 0; w < workers; w++) steals += workpool_worker_stats(pool, w).steals;
+    thread_stats_report(stats, workers);
+    printf("Украдено задач: %lld\n", steals);
+    if (perf.pc) {
+        if (!atomic_load(&perf.available)) fprintf(stderr, PERF_UNAVAILABLE_MSG);
+        perf_report(perf.pc, workers, "Потік");
+        for (int w = 0; w < workers; w++) perf_close(&perf.pc[w]);
+        free(perf.pc);
+    }
+    phase_mark(&phases, PHASE_OUTPUT);
+
+    int rc = 0;
+    if (opts.verify) {
+        verify_ctx v = {&plan, &key, &layout, data, width, height, tile_rows, col_step, 0};
+        long long verify_begin = main_ring ? trace_now() : 0;
+        workpool_run(pool, (height + tile_rows - 1) / tile_rows, verify_tile, &v);
+        long long mismatches = atomic_load(&v.mismatches);
+        printf("Перевірка (CRT) за %f секунд. Розбіжностей: %lld\n",
+               phase_mark(&phases, PHASE_VERIFY), mismatches);
+        if (main_ring) trace_record(main_ring, TRACE_VERIFY, verify_begin, trace_now(), mismatches, 0);
+        if (mismatches) rc = 2;
+    }
+
+    grid_summary summary = {"pthreads", workers, width, height,
+                            grid_kernel_name(plan.kernel), plan.ilp, plan.e, col_step,
+                            t1, global_min, global_max, {0}};
+    if (rc == 0) {
+        long long output_begin = main_ring ? trace_now() : 0;
+        grid_probes_layout(&layout, data, summary.probes);
+
+        printf("Верхній лівий: %llu\n", summary.probes[0]);
+        printf("Верхній правий: %llu\n", summary.probes[1]);
+        printf("Нижній лівий: %llu\n", summary.probes[2]);
+        printf("Нижній правий: %llu\n", summary.probes[3]);
+        printf("Центр: %llu\n", summary.probes[4]);
+
+        if (opts.checksum) {
+            summary.has_fingerprint = 1;
+            summary.fingerprint = fingerprint_finish(result.fp, width, height);
+            if (report_fingerprint(&summary.fingerprint, opts.golden) != 0) rc = 3;
+        }
+        summary.joules = phases.joules[PHASE_COMPUTE];
+        if (opts.summary) print_summary(&summary);
+        if (main_ring) trace_record(main_ring, TRACE_OUTPUT, output_begin, trace_now(), 0, 0);
+        phase_mark(&phases, PHASE_OUTPUT);
+        if (opts.output) {
+            gridfile_header hdr;
+            gridfile_header_init(&hdr, &plan, width, height, col_step);
+            if (gridfile_save(opts.output, &hdr, &layout, data, global_min, global_max) != 0 && rc == 0) rc = 1;
+        }
+    }
+
+    // Кільце основного потоку стає останнім потоком у файлі трасування
+    if (opts.trace) {
+        size_t count, main_count;
+        long long dropped, main_dropped;
+        trace_event *events = trace_collect(&trace, 0, &count, &dropped);
+        trace_event *main_events = trace_collect(&main_trace, 0, &main_count, &main_dropped);
+        trace_event *all = malloc((count + main_count + 1) * sizeof(trace_event));
+        if (events && main_events && all) {
+            for (size_t k = 0; k < count; k++) all[k] = events[k];
+            for (size_t k = 0; k < main_count; k++) {
+                all[count + k] = main_events[k];
+                all[count + k].tid = workers;
+            }
+            if (trace_write(opts.trace, "pthreads", all, count + main_count) != 0 && rc == 0) rc = 1;
+        }
+        free(events);
+        free(main_events);
+        free(all);
+    }
+    trace_free(&trace);
+    trace_free(&main_trace);
+    phase_mark(&phases, PHASE_GATHER);
+
+    if (opts.timing) phase_report(&phases);
+    if (opts.timing_json && phase_write_json(&phases, &summary, opts.timing_json) != 0 && rc == 0) rc = 1;
+    if (phases.has_energy) {
+        phase_energy_report(&phases, (long long)width * height);
+        energy_report(&energy);
+        energy_close(&energy);
+    }
+
+    workpool_destroy(pool);
+    free(stats);
+    grid_buffer_free(&data_buf);
+    grid_layout_free(&layout);
+    return rc;
+}
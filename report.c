@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "report.h"
+
+int report_fingerprint(const grid_fingerprint *fp, const char *golden) {
+    char hex[FINGERPRINT_HEX_LEN];
+    fingerprint_format(*fp, hex);
+    printf("Відбиток сітки: %s\n", hex);
+    if (!golden) return 0;
+
+    grid_fingerprint expected;
+    if (fingerprint_parse(golden, &expected) != 0) {
+        fprintf(stderr, "Некоректний еталонний відбиток: %s\n", golden);
+        return -1;
+    }
+    if (!fingerprint_equal(*fp, expected)) {
+        printf("Відбиток НЕ збігається з еталоном %s\n", golden);
+        return -1;
+    }
+    printf("Відбиток збігається з еталоном\n");
+    return 0;
+}
+
+void grid_probes(const ull *data, int width, int height, ull probes[GRID_PROBES]) {
+    probes[0] = data[0];
+    probes[1] = data[width - 1];
+    probes[2] = data[(size_t) (height - 1) * width];
+    probes[3] = data[(size_t) height * width - 1];
+    probes[4] = data[(size_t) (height / 2) * width + (width / 2)];
+}
+
+void grid_probes_layout(const grid_layout *l, const ull *data, ull probes[GRID_PROBES]) {
+    const int width = l->width, height = l->height;
+    probes[0] = grid_layout_at(l, data, 0, 0);
+    probes[1] = grid_layout_at(l, data, 0, width - 1);
+    probes[2] = grid_layout_at(l, data, height - 1, 0);
+    probes[3] = grid_layout_at(l, data, height - 1, width - 1);
+    probes[4] = grid_layout_at(l, data, height / 2, width / 2);
+}
+
+void print_summary(const grid_summary *s) {
+    char hex[FINGERPRINT_HEX_LEN];
+    fingerprint_format(s->fingerprint, hex);
+    printf("RESULT backend=%s workers=%d width=%d height=%d kernel=%s ilp=%d e=%llu col_step=%llu "
+           "seconds=%.6f min=%llu max=%llu probes=%llu,%llu,%llu,%llu,%llu fingerprint=%s",
+           s->backend, s->workers, s->width, s->height, s->kernel, s->ilp, s->e, s->col_step,
+           s->seconds, s->min, s->max,
+           s->probes[0], s->probes[1], s->probes[2], s->probes[3], s->probes[4],
+           s->has_fingerprint ? hex : "-");
+    if (s->joules > 0.0)
+        printf(" joules=%.3f j_per_mcell=%.6f", s->joules, s->joules / ((double) s->width * s->height / 1e6));
+    printf("\n");
+    fflush(stdout);
+}
+
+void fingerprint_format(grid_fingerprint fp, char *out) {
+    snprintf(out, FINGERPRINT_HEX_LEN, "%016llx%016llx", fp.a, fp.b);
+}
+
+int fingerprint_parse(const char *hex, grid_fingerprint *fp) {
+    if (strlen(hex) != 32 || strspn(hex, "0123456789abcdefABCDEF") != 32) return -1;
+    char half[17];
+    memcpy(half, hex, 16);
+    half[16] = '\0';
+    fp->a = strtoull(half, NULL, 16);
+    fp->b = strtoull(hex + 16, NULL, 16);
+    return 0;
+}
+
+void report_multi_cost(const ull *exps, int count) {
+    long shared, separate;
+    multi_exp_cost(exps, count, &shared, &separate);
+    printf("Експонент %d, множень за модулем на повідомлення: %ld зі спільним ланцюжком, "
+           "%ld окремо (x%.2f)\n", count, shared, separate, (double) separate / shared);
+}
+
+void report_exponent(const grid_summary *s, int summary) {
+    printf("e = %llu: min = %llu, max = %llu, кути %llu %llu %llu %llu, центр %llu\n",
+           s->e, s->min, s->max, s->probes[0], s->probes[1], s->probes[2], s->probes[3], s->probes[4]);
+    if (s->has_fingerprint) report_fingerprint(&s->fingerprint, NULL);
+    if (summary) print_summary(s);
+}
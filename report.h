@@ -0,0 +1,48 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "fingerprint.h"
+#include "gridlayout.h"
+
+// Контрольні клітинки, які друкують драйвери: верхній лівий, верхній правий,
+// нижній лівий, нижній правий кути та центр
+#define GRID_PROBES 5
+
+// Підсумок запуску для --summary
+typedef struct {
+    const char *backend;
+    int workers;            // потоки OpenMP або процеси MPI
+    int width, height;
+    const char *kernel;
+    int ilp;
+    ull e;
+    ull col_step;
+    double seconds;         // час обчислення сітки за вимірюванням драйвера
+    ull min, max;
+    ull probes[GRID_PROBES];
+    int has_fingerprint;
+    grid_fingerprint fingerprint;
+    double joules;          // енергія фази обчислення (--energy), 0 — не вимірювалась
+} grid_summary;
+
+void grid_probes(const ull *data, int width, int height, ull probes[GRID_PROBES]);
+
+// Ті самі клітинки з сітки в довільній розкладці
+void grid_probes_layout(const grid_layout *l, const ull *data, ull probes[GRID_PROBES]);
+
+// Друкує відбиток і, якщо golden не NULL, порівнює з ним.
+// Повертає 0 або -1 при розбіжності чи некоректному еталоні.
+int report_fingerprint(const grid_fingerprint *fp, const char *golden);
+
+// Один рядок "RESULT key=value ..." у stdout
+void print_summary(const grid_summary *s);
+
+// Режим --exponents: рядок з вартістю спільного ланцюжка квадратів проти
+// окремих піднесень для кожної експоненти
+void report_multi_cost(const ull *exps, int count);
+
+// Звіт однієї експоненти режиму --exponents (s->e): min/max, контрольні
+// клітинки, відбиток, якщо has_fingerprint, і RESULT, якщо summary
+void report_exponent(const grid_summary *s, int summary);
+
+#endif
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include "rsa.h"
+
+// Ключ для режиму перевірки (p_const/q_const драйверів — складені числа)
+#define DEFAULT_P 3000000019ULL
+#define DEFAULT_Q 3000000037ULL
+#define DEFAULT_E 900000000000001ULL
+
+static ull gcd_ull(ull a, ull b) {
+    while (b) {
+        ull t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Обернений елемент a за модулем m або 0, якщо його не існує
+static ull modinv(ull a, ull m) {
+    __int128 t = 0, new_t = 1;
+    __int128 r = m, new_r = a % m;
+    while (new_r != 0) {
+        __int128 quot = r / new_r, tmp;
+        tmp = t - quot * new_t; t = new_t; new_t = tmp;
+        tmp = r - quot * new_r; r = new_r; new_r = tmp;
+    }
+    if (r != 1) return 0;
+    if (t < 0) t += m;
+    return (ull) t;
+}
+
+// Детермінований тест Міллера-Рабіна, достатній для n < 2^32
+static int is_prime32(ull n) {
+    static const ull bases[] = {2, 7, 61};
+    if (n < 2) return 0;
+    if (n % 2 == 0) return n == 2;
+    ull d = n - 1;
+    int s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+    for (int i = 0; i < 3; i++) {
+        ull a = bases[i] % n;
+        if (a == 0) continue;
+        ull x = modexp(a, d, n);
+        if (x == 1 || x == n - 1) continue;
+        int composite = 1;
+        for (int r = 1; r < s; r++) {
+            x = (x * x) % n;
+            if (x == n - 1) {
+                composite = 0;
+                break;
+            }
+        }
+        if (composite) return 0;
+    }
+    return 1;
+}
+
+int rsa_key_init(rsa_key *key, ull p, ull q, ull e, ull d) {
+    if (p >= (1ULL << 32) || q >= (1ULL << 32)) {
+        fprintf(stderr, "p та q мають бути меншими за 2^32\n");
+        return -1;
+    }
+    if (!is_prime32(p) || !is_prime32(q) || p == q) {
+        fprintf(stderr, "p = %llu та q = %llu мають бути різними простими числами\n", p, q);
+        return -1;
+    }
+
+    ull lambda = (p - 1) / gcd_ull(p - 1, q - 1) * (q - 1);
+    if (e < 3 || gcd_ull(e, lambda) != 1) {
+        fprintf(stderr, "e = %llu не взаємно просте з lambda(n) = %llu\n", e, lambda);
+        return -1;
+    }
+    if (d == 0) {
+        d = modinv(e % lambda, lambda);
+    } else if (mulmod_u128(e % lambda, d % lambda, lambda) != 1) {
+        fprintf(stderr, "d = %llu не є оберненим до e за модулем lambda(n)\n", d);
+        return -1;
+    }
+
+    key->p = p;
+    key->q = q;
+    key->n = p * q;
+    key->e = e;
+    key->d = d;
+    key->dp = d % (p - 1);
+    key->dq = d % (q - 1);
+    key->qinv = modinv(q % p, p);
+    mont_init(&key->mont_p, p);
+    mont_init(&key->mont_q, q);
+    mont32_init(&key->mont32_p, p);
+    mont32_init(&key->mont32_q, q);
+    return 0;
+}
+
+int rsa_key_default(rsa_key *key) {
+    return rsa_key_init(key, DEFAULT_P, DEFAULT_Q, DEFAULT_E, 0);
+}
+
+void rsa_report_mismatch(int i, int j, ull message, ull ciphertext, ull decrypted) {
+    printf("Розбіжність у (%d, %d): m = %llu, c = %llu, розшифровано %llu\n",
+           i, j, message, ciphertext, decrypted);
+}
+
+int modexp_plan_init(modexp_plan *plan, grid_kernel kernel, ull n, ull e) {
+    plan->kernel = kernel == KERNEL_AUTO ? KERNEL_LEGACY : kernel;
+    plan->n = n;
+    plan->e = e;
+    plan->ilp = 1;
+    plan->stream = 0;
+#if defined(__x86_64__)
+    plan->avx2 = __builtin_cpu_supports("avx2");
+#else
+    plan->avx2 = 0;
+#endif
+    int needs_mont = plan->kernel == KERNEL_CT || plan->kernel == KERNEL_MONT;
+    if (needs_mont && mont_init(&plan->mont, n) != 0) {
+        fprintf(stderr, "Ядро %s потребує непарного n < 2^63, n = %llu\n",
+                grid_kernel_name(plan->kernel), n);
+        return -1;
+    }
+    if (plan->kernel == KERNEL_BARRETT)
+        barrett_init(&plan->barrett, n);
+    return 0;
+}
+
+static int bit_length(ull x) {
+    return x ? 64 - __builtin_clzll(x) : 0;
+}
+
+void multi_exp_cost(const ull *exps, int count, long *shared, long *separate) {
+    *shared = bit_length(multi_exp_bits(exps, count));
+    *separate = 0;
+    for (int k = 0; k < count; k++) {
+        *shared += __builtin_popcountll(exps[k]);
+        *separate += bit_length(exps[k]) + __builtin_popcountll(exps[k]);
+    }
+}
+
+const char *grid_kernel_name(grid_kernel kernel) {
+    switch (kernel) {
+        case KERNEL_LEGACY: return "legacy";
+        case KERNEL_U128: return "u128";
+        case KERNEL_CT: return "ct";
+        case KERNEL_BARRETT: return "barrett";
+        case KERNEL_MONT: return "mont";
+        default: return "auto";
+    }
+}
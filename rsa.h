@@ -0,0 +1,348 @@
+#ifndef RSA_H
+#define RSA_H
+
+#include "kernels.h"
+#include "gridmem.h"
+
+// RSA ключ з CRT-параметрами. p та q < 2^32, тож n < 2^64,
+// а всі добутки за модулем p чи q вміщуються у 64 біти.
+typedef struct {
+    ull p, q, n;
+    ull e, d;
+    ull dp, dq, qinv;
+    mont_ctx mont_p, mont_q;    // для сталочасового розшифрування
+    mont32_ctx mont32_p, mont32_q;  // для пакетного розшифрування перевірки
+} rsa_key;
+
+// Перевіряє ключ і обчислює d (якщо d == 0), dp, dq та qinv.
+// Повертає 0 або -1 з повідомленням у stderr.
+int rsa_key_init(rsa_key *key, ull p, ull q, ull e, ull d);
+
+// Ключ за замовчуванням для режиму перевірки: прості числа поруч
+// з p_const/q_const драйверів і експонента того ж порядку, що e_const.
+int rsa_key_default(rsa_key *key);
+
+// Розшифрування через CRT: два піднесення за модулями розміром у половину n
+// з удвічі коротшими експонентами замість одного modexp з d.
+static inline ull rsa_decrypt_crt(const rsa_key *key, ull c) {
+    ull m1 = modexp(c % key->p, key->dp, key->p);
+    ull m2 = modexp(c % key->q, key->dq, key->q);
+    ull h = (key->qinv * ((m1 + key->p - m2 % key->p) % key->p)) % key->p;
+    return m2 + h * key->q;
+}
+
+// Рекомбінація m1 = c^dp mod p, m2 = c^dq mod q без ділення
+static inline ull rsa_crt_combine(const rsa_key *key, ull m1, ull m2) {
+    const mont_ctx *mp = &key->mont_p;
+    ull a = mont_mul(mp, m1, mp->r2);
+    ull b = mont_mul(mp, m2, mp->r2);
+    ull diff = a - b + (key->p & -(ull) (a < b));
+    ull h = mont_mul(mp, diff, key->qinv);
+    return m2 + h * key->q;
+}
+
+// Сталочасовий варіант CRT: обидва піднесення — сходинки Монтгомері
+// на 32 біти, рекомбінація без ділення на секретних значеннях.
+static inline ull rsa_decrypt_crt_ct(const rsa_key *key, ull c) {
+    ull m1 = modexp_ladder(&key->mont_p, c, key->dp, 32);
+    ull m2 = modexp_ladder(&key->mont_q, c, key->dq, 32);
+    return rsa_crt_combine(key, m1, m2);
+}
+
+// Крок сходинок Монтгомері для одного ланцюжка, як у modexp_ladder
+static inline void mont32_ladder_step(const mont32_ctx *ctx, ull swap, ull *r0, ull *r1) {
+    ull x = ct_select(swap, *r1, *r0);
+    ull y = ct_select(swap, *r0, *r1);
+    y = mont32_mul(ctx, x, y);
+    x = mont32_mul(ctx, x, x);
+    *r0 = ct_select(swap, y, x);
+    *r1 = ct_select(swap, x, y);
+}
+
+// `w` <= ILP_MAX шифротекстів одним чергуванням. Піднесення за p та q
+// ідуть в одному циклі з R = 2^32, тож незалежних ланцюжків 2 * w. Без ct
+// — бінарне піднесення справа наліво, як у modexp_mont_ilp, з ct — 32
+// кроки сходинок з масками лише від dp та dq. Параметр `w` останній і має
+// бути сталою у місці виклику (див. ILP_CALL).
+static inline __attribute__((always_inline))
+void rsa_decrypt_crt_ilp(const rsa_key *key, const ull *c, ull *out, int ct, int w) {
+    const mont32_ctx *mp = &key->mont32_p, *mq = &key->mont32_q;
+    ull rp[ILP_MAX], rq[ILP_MAX], bp[ILP_MAX], bq[ILP_MAX];
+    for (int k = 0; k < w; k++) {
+        rp[k] = mp->r1;
+        rq[k] = mq->r1;
+        bp[k] = mont32_to(mp, c[k]);
+        bq[k] = mont32_to(mq, c[k]);
+    }
+    if (ct) {
+        for (int bit = 31; bit >= 0; bit--) {
+            ull swap_p = -((key->dp >> bit) & 1), swap_q = -((key->dq >> bit) & 1);
+            for (int k = 0; k < w; k++) {
+                mont32_ladder_step(mp, swap_p, &rp[k], &bp[k]);
+                mont32_ladder_step(mq, swap_q, &rq[k], &bq[k]);
+            }
+        }
+    } else {
+        ull ep = key->dp, eq = key->dq;
+        while (ep | eq) {
+            if (ep & 1)
+                for (int k = 0; k < w; k++) rp[k] = mont32_mul(mp, rp[k], bp[k]);
+            if (eq & 1)
+                for (int k = 0; k < w; k++) rq[k] = mont32_mul(mq, rq[k], bq[k]);
+            ep >>= 1;
+            eq >>= 1;
+            for (int k = 0; k < w; k++) {
+                if (ep) bp[k] = mont32_mul(mp, bp[k], bp[k]);
+                if (eq) bq[k] = mont32_mul(mq, bq[k], bq[k]);
+            }
+        }
+    }
+    for (int k = 0; k < w; k++)
+        out[k] = rsa_crt_combine(key, mont32_from(mp, rp[k]), mont32_from(mq, rq[k]));
+}
+
+// Ядро піднесення до степеня для сітки, вибирається --kernel
+typedef enum {
+    KERNEL_AUTO,    // legacy, а в режимі перевірки — u128
+    KERNEL_LEGACY,  // `%` на 64 бітах, як в оригінальних драйверах
+    KERNEL_U128,    // точне множення через __int128
+    KERNEL_CT,      // сталочасові сходинки Монтгомері
+    KERNEL_BARRETT, // редукція Барретта без ділення
+    KERNEL_MONT,    // множення Монтгомері, звичайне бінарне піднесення
+} grid_kernel;
+
+// Ядро разом з модулем, експонентою та передобчисленими константами
+typedef struct {
+    grid_kernel kernel;
+    ull n, e;
+    mont_ctx mont;
+    barrett_ctx barrett;
+    int ilp;        // скільки клітинок рядка рахувати одночасно, 1..ILP_MAX
+    int stream;     // писати рядки сітки повз кеш
+    int avx2;       // перевірка розшифровує p та q у лантах AVX2
+} modexp_plan;
+
+// Повертає 0 або -1 з повідомленням у stderr. Ширина ILP — 1, змінюється через plan->ilp.
+int modexp_plan_init(modexp_plan *plan, grid_kernel kernel, ull n, ull e);
+
+const char *grid_kernel_name(grid_kernel kernel);
+
+static inline ull plan_modexp(const modexp_plan *plan, ull base) {
+    switch (plan->kernel) {
+        case KERNEL_U128:
+            return modexp_u128(base, plan->e, plan->n);
+        case KERNEL_CT:
+            return modexp_ladder(&plan->mont, base, plan->e, 64);
+        case KERNEL_BARRETT:
+            return modexp_barrett(&plan->barrett, base, plan->e);
+        case KERNEL_MONT:
+            return modexp_mont(&plan->mont, base, plan->e);
+        default:
+            return modexp(base, plan->e, plan->n);
+    }
+}
+
+// `w` <= ILP_MAX повідомлень одним чергуванням ланцюжків
+static inline void plan_modexp_batch(const modexp_plan *plan, const ull *base, ull *out, int w) {
+    if (w == 1) {
+        out[0] = plan_modexp(plan, base[0]);
+        return;
+    }
+    switch (plan->kernel) {
+        case KERNEL_U128:
+            ILP_CALL(modexp_u128_ilp, w, base, out, plan->e, plan->n);
+            break;
+        case KERNEL_CT:
+            ILP_CALL(modexp_ladder_ilp, w, &plan->mont, base, out, plan->e, 64);
+            break;
+        case KERNEL_BARRETT:
+            ILP_CALL(modexp_barrett_ilp, w, &plan->barrett, base, out, plan->e);
+            break;
+        case KERNEL_MONT:
+            ILP_CALL(modexp_mont_ilp, w, &plan->mont, base, out, plan->e);
+            break;
+        default:
+            ILP_CALL(modexp_ilp, w, base, out, plan->e, plan->n);
+            break;
+    }
+}
+
+// Шифрує рядок з повідомленнями row_base + j * col_step для j < width
+// групами по plan->ilp клітинок і оновлює *min та *max. З plan->stream
+// група рахується в локальний масив і пишеться в out потоковими записами.
+static inline void plan_encrypt_row(const modexp_plan *plan, ull row_base, ull col_step,
+                                    ull *out, int width, ull *min, ull *max) {
+    ull lo = *min, hi = *max;
+    ull messages[ILP_MAX], results[ILP_MAX];
+    for (int j = 0; j < width; j += plan->ilp) {
+        int count = width - j < plan->ilp ? width - j : plan->ilp;
+        for (int k = 0; k < count; k++)
+            messages[k] = row_base + (ull) (j + k) * col_step;
+        ull *dst = plan->stream ? results : out + j;
+        plan_modexp_batch(plan, messages, dst, count);
+        for (int k = 0; k < count; k++) {
+            ull ciphertext = dst[k];
+            if (ciphertext < lo) lo = ciphertext;
+            if (ciphertext > hi) hi = ciphertext;
+            if (plan->stream) grid_stream_store(&out[j + k], ciphertext);
+        }
+    }
+    if (plan->stream) grid_stream_fence();
+    *min = lo;
+    *max = hi;
+}
+
+// count довільних повідомлень (не рядок сітки) групами по plan->ilp
+static inline void plan_encrypt_messages(const modexp_plan *plan, const ull *messages, ull *out, long count) {
+    for (long k = 0; k < count; k += plan->ilp) {
+        int w = count - k < plan->ilp ? (int) (count - k) : plan->ilp;
+        plan_modexp_batch(plan, messages + k, out + k, w);
+    }
+}
+
+// `w` <= ILP_MAX повідомлень для count експонент зі спільним ланцюжком
+// квадратів; out[k * w + m] — експонента k, повідомлення m. Сталочасові
+// сходинки не діляться ланцюжком без витоку бітів експонент, тож для ct
+// кожна експонента рахується окремо.
+static inline void plan_modexp_multi(const modexp_plan *plan, const ull *base, ull *out,
+                                     const ull *exps, int count, int w) {
+    switch (plan->kernel) {
+        case KERNEL_U128:
+            ILP_CALL(modexp_u128_multi, w, base, out, exps, count, plan->n);
+            break;
+        case KERNEL_CT:
+            for (int k = 0; k < count; k++)
+                for (int m = 0; m < w; m++) out[k * w + m] = modexp_ladder(&plan->mont, base[m], exps[k], 64);
+            break;
+        case KERNEL_BARRETT:
+            ILP_CALL(modexp_barrett_multi, w, &plan->barrett, base, out, exps, count);
+            break;
+        case KERNEL_MONT:
+            ILP_CALL(modexp_mont_multi, w, &plan->mont, base, out, exps, count);
+            break;
+        default:
+            ILP_CALL(modexp_multi, w, base, out, exps, count, plan->n);
+            break;
+    }
+}
+
+// Рядок для count експонент групами по plan->ilp клітинок: out[k] — рядок
+// сітки k-ї експоненти, min[k] та max[k] оновлюються як у plan_encrypt_row
+static inline void plan_encrypt_row_multi(const modexp_plan *plan, const ull *exps, int count,
+                                          ull row_base, ull col_step, ull *const *out, int width,
+                                          ull *min, ull *max) {
+    ull messages[ILP_MAX], results[MULTI_EXP_MAX * ILP_MAX];
+    for (int j = 0; j < width; j += plan->ilp) {
+        int w = width - j < plan->ilp ? width - j : plan->ilp;
+        for (int m = 0; m < w; m++)
+            messages[m] = row_base + (ull) (j + m) * col_step;
+        plan_modexp_multi(plan, messages, results, exps, count, w);
+        for (int k = 0; k < count; k++) {
+            for (int m = 0; m < w; m++) {
+                ull ciphertext = results[k * w + m];
+                out[k][j + m] = ciphertext;
+                if (ciphertext < min[k]) min[k] = ciphertext;
+                if (ciphertext > max[k]) max[k] = ciphertext;
+            }
+        }
+    }
+}
+
+// Множень за модулем на повідомлення: зі спільним ланцюжком і для count
+// окремих піднесень
+void multi_exp_cost(const ull *exps, int count, long *shared, long *separate);
+
+static inline ull plan_decrypt(const modexp_plan *plan, const rsa_key *key, ull c) {
+    return plan->kernel == KERNEL_CT ? rsa_decrypt_crt_ct(key, c)
+                                     : rsa_decrypt_crt(key, c);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static inline void mont32_ladder_step_avx2(__m256i *r0, __m256i *r1, __m256i swap, __m256i n, __m256i ninv) {
+    __m256i x = _mm256_blendv_epi8(*r0, *r1, swap);
+    __m256i y = _mm256_blendv_epi8(*r1, *r0, swap);
+    y = mont32_mul_avx2(x, y, n, ninv);
+    x = mont32_mul_avx2(x, x, n, ninv);
+    *r0 = _mm256_blendv_epi8(x, y, swap);
+    *r1 = _mm256_blendv_epi8(y, x, swap);
+}
+
+// rsa_decrypt_crt_ilp для groups <= ILP_MAX / SIMD_LANES груп по SIMD_LANES
+// шифротекстів: клітинка групи — лана AVX2, групи й модулі чергуються.
+// Викликати лише з plan->avx2.
+__attribute__((target("avx2")))
+static inline void rsa_decrypt_crt_avx2(const rsa_key *key, const ull *c, ull *out, int ct, int groups) {
+    enum { GROUPS = ILP_MAX / SIMD_LANES };
+    const mont32_ctx *mp = &key->mont32_p, *mq = &key->mont32_q;
+    const __m256i np = _mm256_set1_epi64x((ll) mp->n), ip = _mm256_set1_epi64x((ll) mp->ninv);
+    const __m256i nq = _mm256_set1_epi64x((ll) mq->n), iq = _mm256_set1_epi64x((ll) mq->ninv);
+    __m256i rp[GROUPS], rq[GROUPS], bp[GROUPS], bq[GROUPS];
+    ull lanes_p[SIMD_LANES], lanes_q[SIMD_LANES];
+    for (int g = 0; g < groups; g++) {
+        for (int l = 0; l < SIMD_LANES; l++) {
+            lanes_p[l] = c[g * SIMD_LANES + l] % mp->n;
+            lanes_q[l] = c[g * SIMD_LANES + l] % mq->n;
+        }
+        bp[g] = mont32_mul_avx2(_mm256_loadu_si256((const __m256i *) lanes_p),
+                                _mm256_set1_epi64x((ll) mp->r2), np, ip);
+        bq[g] = mont32_mul_avx2(_mm256_loadu_si256((const __m256i *) lanes_q),
+                                _mm256_set1_epi64x((ll) mq->r2), nq, iq);
+        rp[g] = _mm256_set1_epi64x((ll) mp->r1);
+        rq[g] = _mm256_set1_epi64x((ll) mq->r1);
+    }
+    if (ct) {
+        for (int bit = 31; bit >= 0; bit--) {
+            __m256i swap_p = _mm256_set1_epi64x(-(ll) ((key->dp >> bit) & 1));
+            __m256i swap_q = _mm256_set1_epi64x(-(ll) ((key->dq >> bit) & 1));
+            for (int g = 0; g < groups; g++) {
+                mont32_ladder_step_avx2(&rp[g], &bp[g], swap_p, np, ip);
+                mont32_ladder_step_avx2(&rq[g], &bq[g], swap_q, nq, iq);
+            }
+        }
+    } else {
+        ull ep = key->dp, eq = key->dq;
+        while (ep | eq) {
+            for (int g = 0; g < groups; g++) {
+                if (ep & 1) rp[g] = mont32_mul_avx2(rp[g], bp[g], np, ip);
+                if (eq & 1) rq[g] = mont32_mul_avx2(rq[g], bq[g], nq, iq);
+            }
+            ep >>= 1;
+            eq >>= 1;
+            for (int g = 0; g < groups; g++) {
+                if (ep) bp[g] = mont32_mul_avx2(bp[g], bp[g], np, ip);
+                if (eq) bq[g] = mont32_mul_avx2(bq[g], bq[g], nq, iq);
+            }
+        }
+    }
+    const __m256i one = _mm256_set1_epi64x(1);
+    for (int g = 0; g < groups; g++) {
+        _mm256_storeu_si256((__m256i *) lanes_p, mont32_mul_avx2(rp[g], one, np, ip));
+        _mm256_storeu_si256((__m256i *) lanes_q, mont32_mul_avx2(rq[g], one, nq, iq));
+        for (int l = 0; l < SIMD_LANES; l++)
+            out[g * SIMD_LANES + l] = rsa_crt_combine(key, lanes_p[l], lanes_q[l]);
+    }
+}
+#endif
+
+// Розшифрування для перевірки: `w` <= plan->ilp шифротекстів за раз, щоб
+// перевірка йшла з тією ж шириною ILP, що й шифрування. Повні групи по
+// SIMD_LANES з AVX2 рахуються у векторних лантах.
+static inline void plan_decrypt_batch(const modexp_plan *plan, const rsa_key *key, const ull *c, ull *out, int w) {
+    int ct = plan->kernel == KERNEL_CT;
+#if defined(__x86_64__)
+    if (plan->avx2 && w % SIMD_LANES == 0) {
+        rsa_decrypt_crt_avx2(key, c, out, ct, w / SIMD_LANES);
+        return;
+    }
+#endif
+    ILP_CALL(rsa_decrypt_crt_ilp, w, key, c, out, ct);
+}
+
+// Скільки розбіжностей друкувати до того, як лише рахувати їх.
+#define VERIFY_REPORT_LIMIT 10
+
+// Друкує клітинку (i, j), для якої розшифрування не дало вихідного повідомлення
+void rsa_report_mismatch(int i, int j, ull message, ull ciphertext, ull decrypted);
+
+#endif
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "rsagrid.h"
+#include "gridpool.h"
+#include "timing.h"
+
+// n_const та e_const драйверів
+#define DEFAULT_N 9000000054000000077ULL
+#define DEFAULT_E 900000000000000ULL
+#define DEFAULT_SIZE 3000
+
+struct rsagrid {
+    rsagrid_config cfg;
+    modexp_plan plan;
+    workpool *pool;             // NULL для RSAGRID_SEQ
+    int own_pool;
+    int workers;
+    ull *scratch;               // плитки без буфера викликача
+    ull *output;
+    size_t stride;
+    rsagrid_tile_fn on_tile;
+    void *user;
+    int row0, rows, col0, cols; // прямокутник поточного обчислення
+    ull probes[GRID_PROBES];
+};
+
+void rsagrid_config_default(rsagrid_config *cfg) {
+    cfg->n = DEFAULT_N;
+    cfg->e = DEFAULT_E;
+    cfg->width = DEFAULT_SIZE;
+    cfg->height = DEFAULT_SIZE;
+    cfg->col_step = 0;
+    cfg->kernel = KERNEL_LEGACY;
+    cfg->ilp = 1;
+    cfg->backend = RSAGRID_THREADS;
+    cfg->threads = 0;
+    cfg->pool = NULL;
+    cfg->tile_rows = 0;
+    cfg->checksum = 1;
+}
+
+rsagrid *rsagrid_create(const rsagrid_config *cfg) {
+    if (cfg->width < 1 || cfg->height < 1) {
+        fprintf(stderr, "Некоректний розмір сітки: %dx%d\n", cfg->width, cfg->height);
+        return NULL;
+    }
+    if (cfg->ilp < 1 || cfg->ilp > ILP_MAX) {
+        fprintf(stderr, "ILP має бути від 1 до %d\n", ILP_MAX);
+        return NULL;
+    }
+    rsagrid *g = calloc(1, sizeof(*g));
+    if (!g) return NULL;
+    g->cfg = *cfg;
+    if (g->cfg.col_step == 0) g->cfg.col_step = (ull) cfg->width;
+    if (g->cfg.tile_rows < 1) g->cfg.tile_rows = POOL_TILE_ROWS;
+    if (g->cfg.tile_rows > cfg->height) g->cfg.tile_rows = cfg->height;
+    if (modexp_plan_init(&g->plan, cfg->kernel, cfg->n, cfg->e) != 0) {
+        free(g);
+        return NULL;
+    }
+    g->plan.ilp = cfg->ilp;
+
+    g->workers = 1;
+    if (cfg->backend == RSAGRID_THREADS && cfg->pool) {
+        g->pool = cfg->pool;
+        g->workers = workpool_size(cfg->pool);
+    } else if (cfg->backend == RSAGRID_THREADS) {
+        g->workers = cfg->threads > 0 ? cfg->threads : (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (g->workers < 1) g->workers = 1;
+        g->pool = workpool_create(g->workers);
+        if (!g->pool) {
+            fprintf(stderr, "Помилка створення пулу потоків!\n");
+            free(g);
+            return NULL;
+        }
+        g->own_pool = 1;
+    }
+    return g;
+}
+
+int rsagrid_set_output(rsagrid *g, ull *buffer, size_t stride) {
+    if (stride == 0) stride = (size_t) g->cfg.width;
+    g->output = buffer;
+    g->stride = stride;
+    return 0;
+}
+
+void rsagrid_set_tile_callback(rsagrid *g, rsagrid_tile_fn fn, void *user) {
+    g->on_tile = fn;
+    g->user = user;
+}
+
+int rsagrid_workers(const rsagrid *g) {
+    return g->workers;
+}
+
+// Контрольні клітинки — з плиток, бо повної сітки може й не бути.
+// Кожну пише рівно одна плитка.
+static void tile_done(void *ctx, int first, int rows, const ull *cells, size_t stride, int worker) {
+    rsagrid *g = ctx;
+    const int width = g->cols, height = g->rows;
+    const int probe_row[GRID_PROBES] = {0, 0, height - 1, height - 1, height / 2};
+    const int probe_col[GRID_PROBES] = {0, width - 1, 0, width - 1, width / 2};
+    for (int k = 0; k < GRID_PROBES; k++) {
+        int r = g->row0 + probe_row[k];
+        if (r >= first && r < first + rows) g->probes[k] = cells[(size_t) (r - first) * stride + probe_col[k]];
+    }
+
+    if (g->on_tile) {
+        rsagrid_tile tile = {first, rows, width, cells, stride, worker};
+        g->on_tile(g->user, &tile);
+    }
+}
+
+int rsagrid_compute_region(rsagrid *g, int row, int col, int rows, int cols, rsagrid_result *result) {
+    const rsagrid_config *cfg = &g->cfg;
+    if (row < 0 || col < 0 || rows < 1 || cols < 1 || rows > cfg->height - row || cols > cfg->width - col) {
+        fprintf(stderr, "Прямокутник %dx%d з (%d, %d) виходить за сітку %dx%d\n",
+                rows, cols, row, col, cfg->width, cfg->height);
+        return -1;
+    }
+    if (g->output && g->stride < (size_t) cols) {
+        fprintf(stderr, "Крок рядків %zu менший за ширину %d\n", g->stride, cols);
+        return -1;
+    }
+    if (!g->output && !g->scratch) {
+        g->scratch = malloc((size_t) g->workers * cfg->tile_rows * cfg->width * sizeof(ull));
+        if (!g->scratch) {
+            fprintf(stderr, "Помилка виділення пам'яті!\n");
+            return -1;
+        }
+    }
+    g->row0 = row;
+    g->rows = rows;
+    g->col0 = col;
+    g->cols = cols;
+
+    grid_pool_job job = {&g->plan, g->output, cfg->width, cfg->height, cfg->col_step,
+                         cfg->tile_rows, cfg->checksum, NULL, NULL, NULL,
+                         g->stride, g->scratch, row, rows, col, cols, tile_done, g};
+    grid_reduction red;
+    double start = wall_now();
+    grid_pool_encrypt(g->pool, &job, &red);
+
+    result->seconds = wall_now() - start;
+    result->min = red.min;
+    result->max = red.max;
+    for (int k = 0; k < GRID_PROBES; k++) result->probes[k] = g->probes[k];
+    result->has_fingerprint = cfg->checksum;
+    result->fingerprint = cfg->checksum ? fingerprint_finish(red.fp, cols, rows)
+                                        : (grid_fingerprint) {0, 0};
+    return 0;
+}
+
+int rsagrid_compute(rsagrid *g, rsagrid_result *result) {
+    return rsagrid_compute_region(g, 0, 0, g->cfg.height, g->cfg.width, result);
+}
+
+void rsagrid_destroy(rsagrid *g) {
+    if (!g) return;
+    if (g->own_pool) workpool_destroy(g->pool);
+    free(g->scratch);
+    free(g);
+}
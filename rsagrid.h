@@ -0,0 +1,92 @@
+#ifndef RSAGRID_H
+#define RSAGRID_H
+
+#include <stddef.h>
+#include "rsa.h"
+#include "fingerprint.h"
+#include "report.h"
+#include "workpool.h"
+
+// librsagrid: шифрування сітки як бібліотека, без драйверів і їхнього stdout.
+// Контекст тримає ключ, розміри сітки та бекенд. Результат або пишеться
+// на місці у буфер викликача, або віддається плитками у зворотний виклик,
+// поки плитка ще в кеші; редукції (min, max, контрольні клітинки, відбиток)
+// рахуються в будь-якому разі.
+//
+//   rsagrid_config cfg;
+//   rsagrid_config_default(&cfg);
+//   cfg.width = 1024;
+//   rsagrid *g = rsagrid_create(&cfg);
+//   rsagrid_set_output(g, buffer, 1024);
+//   rsagrid_compute(g, &result);
+//   rsagrid_destroy(g);
+//
+// Помилки — -1 або NULL з повідомленням у stderr, як у решті rsacore.
+
+typedef enum {
+    RSAGRID_SEQ,        // у викликаючому потоці
+    RSAGRID_THREADS,    // постійний пул pthreads з крадіжкою роботи (workpool)
+} rsagrid_backend;
+
+typedef struct {
+    ull n, e;               // відкритий ключ
+    int width, height;
+    ull col_step;           // повідомлення клітинки (i, j) — i * width + j * col_step; 0 — width
+    grid_kernel kernel;
+    int ilp;                // 1..ILP_MAX
+    rsagrid_backend backend;
+    int threads;            // RSAGRID_THREADS: 0 — за кількістю CPU
+    workpool *pool;         // RSAGRID_THREADS: спільний пул викликача замість власного
+    int tile_rows;          // рядків у плитці; 0 — POOL_TILE_ROWS
+    int checksum;           // рахувати відбиток сітки
+} rsagrid_config;
+
+// Готова плитка: рядки row..row+rows-1, клітинка (row + r, j) — cells[r * stride + j].
+// Без буфера викликача cells вказує на робочий буфер виконавця і дійсна лише
+// під час виклику.
+typedef struct {
+    int row, rows, width;
+    const ull *cells;
+    size_t stride;
+    int worker;
+} rsagrid_tile;
+
+// Викликається паралельно з кількох виконавців для різних плиток
+typedef void (*rsagrid_tile_fn)(void *user, const rsagrid_tile *tile);
+
+typedef struct {
+    ull min, max;
+    ull probes[GRID_PROBES];        // як grid_probes у драйверах, для прямокутника — його кути та центр
+    int has_fingerprint;
+    grid_fingerprint fingerprint;   // той самий, що друкують драйвери з --checksum;
+                                    // для прямокутника прив'язаний до його розміру
+    double seconds;
+} rsagrid_result;
+
+typedef struct rsagrid rsagrid;
+
+// Ключ і сітка драйверів: n_const, e_const, 3000x3000, diag, legacy, пул на всіх CPU
+void rsagrid_config_default(rsagrid_config *cfg);
+
+rsagrid *rsagrid_create(const rsagrid_config *cfg);
+
+// Результат прямо в buffer, рядок i починається з buffer + i * stride
+// (stride >= width, 0 — width). NULL — без буфера, лише плитки та редукції.
+int rsagrid_set_output(rsagrid *g, ull *buffer, size_t stride);
+
+// fn == NULL вимикає зворотний виклик
+void rsagrid_set_tile_callback(rsagrid *g, rsagrid_tile_fn fn, void *user);
+
+// Шифрує всю сітку; контекст можна використовувати повторно
+int rsagrid_compute(rsagrid *g, rsagrid_result *result);
+
+// Лише прямокутник rows x cols з лівим верхнім кутом (row, col); клітинки ті
+// самі, що й у повній сітці. Буфер викликача отримує прямокутник з його
+// першої клітинки, тож крок має бути не меншим за cols.
+int rsagrid_compute_region(rsagrid *g, int row, int col, int rows, int cols, rsagrid_result *result);
+
+int rsagrid_workers(const rsagrid *g);
+
+void rsagrid_destroy(rsagrid *g);
+
+#endif
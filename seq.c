@@ -2,10 +2,14 @@
 #include <stdlib.h>
 #include <math.h>
 #include <limits.h>
-#include <time.h>
-
-typedef unsigned long long ull;
-typedef long long ll;
+#include "rsa.h"
+#include "options.h"
+#include "report.h"
+#include "progress.h"
+#include "trace.h"
+#include "timing.h"
+#include "perf_counters.h"
+#include "gridfile.h"
 
 #define WIDTH   3000
 #define HEIGHT  3000
@@ -15,53 +19,280 @@ const ll q_const = 3000000011LL;
 const ll n_const = p_const * q_const;
 const ll e_const = 90000000000000LL;
 
-ull modexp(ull base, ll exp, ull mod) {
-    ull result = 1;
-    base %= mod;
-    while (exp > 0) {
-        if (exp & 1) result = (result * base) % mod;
-        exp >>= 1;
-        base = (base * base) % mod;
+// Режим --exponents: по сітці на кожну експоненту, квадрати повідомлення
+// рахуються один раз для всіх
+static int run_exponents(const grid_options *opts, const modexp_plan *plan,
+                         int width, int height, ull col_step) {
+    int count = opts->exponent_count;
+    grid_buffer bufs[MULTI_EXP_MAX];
+    ull *grids[MULTI_EXP_MAX], *rows[MULTI_EXP_MAX];
+    ull mins[MULTI_EXP_MAX], maxs[MULTI_EXP_MAX];
+    grid_fingerprint fps[MULTI_EXP_MAX];
+    for (int k = 0; k < count; k++) {
+        grids[k] = grid_buffer_alloc(&bufs[k], (size_t)width * height, opts->pages);
+        if (!grids[k]) {
+            fprintf(stderr, "Помилка виділення пам'яті!\n");
+            while (k--) grid_buffer_free(&bufs[k]);
+            return 1;
+        }
+        mins[k] = ULLONG_MAX;
+        maxs[k] = 0;
+        fps[k] = (grid_fingerprint){0, 0};
+    }
+
+    double t0 = wall_now();
+    for (int i = 0; i < height; i++) {
+        for (int k = 0; k < count; k++) rows[k] = &grids[k][(size_t)i * width];
+        plan_encrypt_row_multi(plan, opts->exponents, count, (ull)i * width, col_step,
+                               rows, width, mins, maxs);
+        if (opts->checksum)
+            for (int k = 0; k < count; k++)
+                fingerprint_add(&fps[k], fingerprint_row((ull)i * width, rows[k], width));
+    }
+    double elapsed = wall_now() - t0;
+
+    printf("Згенеровано %d сіток %dx%d за %.3f с\n", count, width, height, elapsed);
+    if (plan->kernel != KERNEL_CT) report_multi_cost(opts->exponents, count);
+    for (int k = 0; k < count; k++) {
+        grid_summary summary = {"seq", 1, width, height, grid_kernel_name(plan->kernel), plan->ilp,
+                                opts->exponents[k], col_step, elapsed, mins[k], maxs[k], {0}};
+        grid_probes(grids[k], width, height, summary.probes);
+        if (opts->checksum) {
+            summary.has_fingerprint = 1;
+            summary.fingerprint = fingerprint_finish(fps[k], width, height);
+        }
+        report_exponent(&summary, opts->summary);
+        grid_buffer_free(&bufs[k]);
     }
-    return result;
+    return 0;
 }
 
-int main(void) {
+// Режим --extend: рядки нової сітки потоком з файлу у файл, шифруються
+// лише клітинки за межами збереженої сітки
+static int run_extend(const grid_options *opts, const modexp_plan *plan, int width, int height) {
+    gridfile_map old;
+    grid_extension x;
+    gridfile_writer w;
+    ull min, max;
+    if (gridfile_open(&old, opts->extend) != 0) return 1;
+    if (grid_extension_init(&x, plan, &old, width, height) != 0 ||
+        grid_extension_begin(&x, &w, opts->output ? opts->output : opts->extend, &min, &max) != 0) {
+        gridfile_close(&old);
+        return 1;
+    }
+    ull *row = malloc((size_t)width * sizeof(ull));
+    if (!row) {
+        fprintf(stderr, "Помилка виділення пам'яті!\n");
+        gridfile_abort(&w);
+        gridfile_close(&old);
+        return 1;
+    }
+
+    double t0 = wall_now();
+    long long computed = 0;
+    for (int i = 0; i < height; i++) {
+        computed += grid_extension_row(&x, i, row, &min, &max);
+        if (gridfile_write_rows(&w, row, 1) != 0) {
+            free(row);
+            gridfile_abort(&w);
+            gridfile_close(&old);
+            return 1;
+        }
+    }
+
+    grid_summary summary = {"seq", 1, width, height, grid_kernel_name(plan->kernel), plan->ilp,
+                            plan->e, x.col_step, wall_now() - t0, min, max, {0}};
+    int rc = grid_extension_finish(&x, &w, opts, &summary, computed, min, max);
+    free(row);
+    gridfile_close(&old);
+    return rc;
+}
+
+static void preview_encrypt(void *ctx, const ull *messages, ull *out, long count) {
+    plan_encrypt_messages(ctx, messages, out, count);
+}
+
+int main(int argc, char *argv[]) {
     int i, j;
 
-    ull *data = malloc(WIDTH * HEIGHT * sizeof(ull));
+    grid_options opts;
+    rsa_key key;
+    modexp_plan plan;
+    if (parse_options(argc, argv, &opts) != 0) return 1;
+    if (options_setup(&opts, n_const, e_const, &key, &plan) != 0) return 1;
+
+    int width = opts.width ? opts.width : WIDTH;
+    int height = opts.height ? opts.height : HEIGHT;
+    // Повідомлення клітинки (i, j) — i * width + j * col_step, за замовчуванням i * width + j
+    ull col_step = grid_col_step(&opts, FORMULA_ROW, width);
+    if (opts.exponent_count) return run_exponents(&opts, &plan, width, height, col_step);
+    if (opts.extend) return run_extend(&opts, &plan, width, height);
+    if (opts.preview > 0.0) {
+        preview_config cfg = {width, height, col_step, plan.n, opts.preview, opts.preview_eps, PREVIEW_SEED};
+        preview_result res;
+        if (preview_run(&cfg, preview_encrypt, NULL, &plan, &res) != 0) return 1;
+        preview_report(&cfg, &res, "seq", 1, opts.summary);
+        return 0;
+    }
+
+    phase_timer phases;
+    phase_init(&phases);
+    energy_meter energy;
+    if (opts.energy) {
+        if (energy_open(&energy, ENERGY_SYSFS) == 0) phase_attach_energy(&phases, &energy);
+        else fprintf(stderr, ENERGY_UNAVAILABLE_MSG);
+    }
+
+    grid_layout layout;
+    if (grid_layout_init(&layout, opts.layout, width, height, opts.layout_tile) != 0) {
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    int units = grid_layout_units(&layout);
+
+    grid_buffer data_buf;
+    ull *data = grid_buffer_alloc(&data_buf, grid_layout_cells(&layout), opts.pages);
     if (!data) {
         fprintf(stderr, "Помилка виділення пам'яті!\n");
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
         return 1;
     }
 
     ull global_min = ULLONG_MAX;
     ull global_max = 0;
 
-    clock_t t0 = clock();
+    grid_fingerprint fp = {0, 0};
+
+    progress_monitor progress;
+    // Одиниця прогресу — рядок або плитка розкладки
+    if (progress_init(&progress, "seq", 1, units, (int)((long long)width * height / units),
+                      opts.progress, opts.progress_file) != 0) {
+        fprintf(stderr, "Помилка виділення лічильників прогресу!\n");
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    if (opts.progress > 0.0 && progress_start(&progress) != 0)
+        fprintf(stderr, "Не вдалося запустити потік прогресу\n");
+
+    trace_log trace;
+    if (trace_init(&trace, opts.trace != NULL, 1, 0) != 0) {
+        fprintf(stderr, "Помилка виділення буфера трасування!\n");
+        if (opts.progress > 0.0) progress_stop(&progress);
+        progress_free(&progress);
+        grid_buffer_free(&data_buf);
+        grid_layout_free(&layout);
+        if (phases.has_energy) energy_close(&energy);
+        return 1;
+    }
+    trace_ring *ring = trace_thread(&trace, 0);
+
+    perf_counters perf;
+    perf_clear(&perf);
+    if (opts.perf && perf_open(&perf) == 0) fprintf(stderr, PERF_UNAVAILABLE_MSG);
+    phase_mark(&phases, PHASE_ALLOC);
+
+    if (opts.perf) perf_begin(&perf);
 
-    for (i = 0; i < HEIGHT; i++) {
-        for (j = 0; j < WIDTH; j++) {
-            ll message = (ll)i * WIDTH + j;
-            ull ciphertext = modexp(message, e_const, n_const);
-            data[i * WIDTH + j] = ciphertext;
+    long long row_begin = ring ? trace_now() : 0;
+    trace_kind unit_kind = layout.kind == LAYOUT_ROW ? TRACE_ROWS : TRACE_TILE;
 
-            if (ciphertext < global_min) global_min = ciphertext;
-            if (ciphertext > global_max) global_max = ciphertext;
+    // Одиниці в порядку зберігання, тож запис іде підряд і для плиток
+    for (int u = 0; u < units; u++) {
+        layout_encrypt_unit(&layout, &plan, col_step, data, u, &global_min, &global_max,
+                            opts.checksum ? &fp : NULL);
+        progress_row_done(&progress.slots[0]);
+        if (ring) {
+            long long row_end = trace_now();
+            trace_record(ring, unit_kind, row_begin, row_end, u, 1);
+            row_begin = row_end;
         }
     }
 
-    double elapsed = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    if (opts.perf) perf_end(&perf, (long long)width * height);
+    double elapsed = phase_mark(&phases, PHASE_COMPUTE);
+    // Зупинка монітора — завершення обчислення, не збір результату
+    if (opts.progress > 0.0) progress_stop(&progress);
+    progress_free(&progress);
+    phase_mark(&phases, PHASE_REDUCE);
     printf("Згенеровано за %.3f с. min = %llu, max = %llu\n",
            elapsed, global_min, global_max);
+    if (opts.perf) {
+        perf_report(&perf, 1, "Потік");
+        perf_close(&perf);
+    }
+    phase_mark(&phases, PHASE_OUTPUT);
+
+    // Після розбіжностей результат не друкується, але звіти фаз, енергія
+    // й звільнення — спільні
+    int rc = 0;
+    if (opts.verify) {
+        ll mismatches = 0;
+        long long verify_begin = ring ? trace_now() : 0;
+        ull ciphertexts[ILP_MAX], decrypted[ILP_MAX];
+        for (i = 0; i < height; i++) {
+            for (j = 0; j < width; j += plan.ilp) {
+                int count = width - j < plan.ilp ? width - j : plan.ilp;
+                for (int k = 0; k < count; k++) ciphertexts[k] = grid_layout_at(&layout, data, i, j + k);
+                plan_decrypt_batch(&plan, &key, ciphertexts, decrypted, count);
+                for (int k = 0; k < count; k++) {
+                    ull message = (ull)i * width + (j + k) * col_step;
+                    if (decrypted[k] != message) {
+                        if (mismatches < VERIFY_REPORT_LIMIT)
+                            rsa_report_mismatch(i, j + k, message, ciphertexts[k], decrypted[k]);
+                        mismatches++;
+                    }
+                }
+            }
+        }
+        double verify_elapsed = phase_mark(&phases, PHASE_VERIFY);
+        if (ring) trace_record(ring, TRACE_VERIFY, verify_begin, trace_now(), mismatches, 0);
+        printf("Перевірка (CRT) за %.3f с. Розбіжностей: %lld\n",
+               verify_elapsed, mismatches);
+        if (mismatches) rc = 2;
+    }
 
-    printf("Верхній лівий:   %llu\n", data[0]);
-    printf("Верхній правий:  %llu\n", data[WIDTH - 1]);
-    printf("Нижній лівий:    %llu\n", data[(HEIGHT - 1) * WIDTH]);
-    printf("Нижній правий:   %llu\n", data[HEIGHT * WIDTH - 1]);
-    printf("Центр:           %llu\n",
-           data[(HEIGHT / 2) * WIDTH + (WIDTH / 2)]);
+    grid_summary summary = {"seq", 1, width, height, grid_kernel_name(plan.kernel), plan.ilp,
+                            plan.e, col_step, elapsed, global_min, global_max, {0}};
+    if (rc == 0) {
+        long long output_begin = ring ? trace_now() : 0;
+        grid_probes_layout(&layout, data, summary.probes);
 
-    free(data);
-    return 0;
+        printf("Верхній лівий:   %llu\n", summary.probes[0]);
+        printf("Верхній правий:  %llu\n", summary.probes[1]);
+        printf("Нижній лівий:    %llu\n", summary.probes[2]);
+        printf("Нижній правий:   %llu\n", summary.probes[3]);
+        printf("Центр:           %llu\n", summary.probes[4]);
+
+        if (opts.checksum) {
+            summary.has_fingerprint = 1;
+            summary.fingerprint = fingerprint_finish(fp, width, height);
+            if (report_fingerprint(&summary.fingerprint, opts.golden) != 0) rc = 3;
+        }
+        summary.joules = phases.joules[PHASE_COMPUTE];
+        if (opts.summary) print_summary(&summary);
+        if (ring) trace_record(ring, TRACE_OUTPUT, output_begin, trace_now(), 0, 0);
+        phase_mark(&phases, PHASE_OUTPUT);
+        if (opts.output) {
+            gridfile_header hdr;
+            gridfile_header_init(&hdr, &plan, width, height, col_step);
+            if (gridfile_save(opts.output, &hdr, &layout, data, global_min, global_max) != 0 && rc == 0) rc = 1;
+        }
+    }
+    if (trace_finish(&trace, opts.trace, "seq") != 0 && rc == 0) rc = 1;
+    phase_mark(&phases, PHASE_GATHER);
+
+    if (opts.timing) phase_report(&phases);
+    if (opts.timing_json && phase_write_json(&phases, &summary, opts.timing_json) != 0 && rc == 0) rc = 1;
+    if (phases.has_energy) {
+        phase_energy_report(&phases, (long long)width * height);
+        energy_report(&energy);
+        energy_close(&energy);
+    }
+
+    grid_buffer_free(&data_buf);
+    grid_layout_free(&layout);
+    return rc;
 }
@@ -0,0 +1,34 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "thread_stats.h"
+
+thread_stats *thread_stats_alloc(int count) {
+    thread_stats *stats = aligned_alloc(CACHE_LINE, count * sizeof(thread_stats));
+    if (stats) memset(stats, 0, count * sizeof(thread_stats));
+    return stats;
+}
+
+void thread_stats_report(const thread_stats *stats, int count) {
+    double busy_sum = 0.0, busy_max = 0.0, wait_sum = 0.0;
+    long long rows_min = -1, rows_max = 0, chunks = 0;
+
+    for (int t = 0; t < count; t++) {
+        const thread_stats *s = &stats[t];
+        printf("Потік %2d: рядків %lld, клітинок %lld, порцій %lld, робота %.3f с, очікування %.3f с\n",
+               t, s->rows, s->cells, s->chunks, s->busy, s->wait);
+        busy_sum += s->busy;
+        wait_sum += s->wait;
+        chunks += s->chunks;
+        if (s->busy > busy_max) busy_max = s->busy;
+        if (rows_min < 0 || s->rows < rows_min) rows_min = s->rows;
+        if (s->rows > rows_max) rows_max = s->rows;
+    }
+
+    // Нерівномірність: наскільки найзавантаженіший потік довший за середній
+    double busy_mean = busy_sum / count;
+    double imbalance = busy_mean > 0.0 ? (busy_max / busy_mean - 1.0) * 100.0 : 0.0;
+    printf("Нерівномірність: %.1f%% (робота max %.3f с, середня %.3f с), "
+           "рядків на потік %lld..%lld, порцій %lld, сумарне очікування %.3f с\n",
+           imbalance, busy_max, busy_mean, rows_min, rows_max, chunks, wait_sum);
+}
@@ -0,0 +1,22 @@
+#ifndef THREAD_STATS_H
+#define THREAD_STATS_H
+
+#define CACHE_LINE 64
+
+// Лічильники одного потоку. Кожен запис займає окрему кеш-лінію, а потік
+// пише в нього лише раз після циклу, тож сусідні потоки не ділять рядків кешу.
+typedef struct {
+    long long rows;
+    long long cells;
+    long long chunks;       // неперервних діапазонів рядків, взятих з черги
+    double busy;            // секунд у циклі обчислення
+    double wait;            // секунд на бар'єрі після циклу
+} __attribute__((aligned(CACHE_LINE))) thread_stats;
+
+// Вирівняний масив з count нульових записів або NULL
+thread_stats *thread_stats_alloc(int count);
+
+// Таблиця по потоках і підсумок нерівномірності навантаження
+void thread_stats_report(const thread_stats *stats, int count);
+
+#endif
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <string.h>
+#include "timing.h"
+
+static const char *phase_names[PHASE_COUNT] = {
+    "alloc", "compute", "reduce", "gather_io", "verify", "output",
+};
+
+void phase_init(phase_timer *t) {
+    memset(t, 0, sizeof(*t));
+    t->start = t->mark = wall_now();
+}
+
+double phase_mark(phase_timer *t, phase_id id) {
+    return phase_mark_at(t, id, wall_now());
+}
+
+double phase_mark_at(phase_timer *t, phase_id id, double when) {
+    double elapsed = when - t->mark;
+    t->seconds[id] += elapsed;
+    t->mark = when;
+    // Лічильник читається зараз, а не в момент when: різниця — мікросекунди
+    if (t->energy) {
+        double joules = energy_read(t->energy);
+        t->joules[id] += joules - t->energy_mark;
+        t->energy_mark = joules;
+    }
+    return elapsed;
+}
+
+void phase_attach_energy(phase_timer *t, energy_meter *m) {
+    t->energy = m;
+    t->has_energy = 1;
+    t->energy_mark = energy_read(m);
+}
+
+void phase_report(const phase_timer *t) {
+    double total = phase_total(t);
+    // Ширина колонок задана пробілами: printf рахує байти, а не літери кирилиці
+    printf("Фаза             секунд   частка%s\n", t->has_energy ? "           Дж        Вт" : "");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        printf("%-10s %12.6f %7.1f%%", phase_names[p], t->seconds[p],
+               total > 0.0 ? 100.0 * t->seconds[p] / total : 0.0);
+        if (t->has_energy)
+            printf(" %12.3f %9.1f", t->joules[p], t->seconds[p] > 0.0 ? t->joules[p] / t->seconds[p] : 0.0);
+        printf("\n");
+    }
+    printf("разом      %12.6f", total);
+    if (t->has_energy) printf("          %12.3f", phase_total_joules(t));
+    printf("\n");
+}
+
+void phase_energy_report(const phase_timer *t, long long cells) {
+    double seconds = t->seconds[PHASE_COMPUTE], joules = t->joules[PHASE_COMPUTE];
+    double mcells = cells / 1e6;
+    printf("Енергія обчислення: %.3f Дж за %.3f с (%.1f Вт), %.4f Дж на мільйон клітинок "
+           "при %.2f млн клітинок/с; весь запуск %.3f Дж\n",
+           joules, seconds, seconds > 0.0 ? joules / seconds : 0.0, mcells > 0.0 ? joules / mcells : 0.0,
+           seconds > 0.0 ? mcells / seconds : 0.0, phase_total_joules(t));
+}
+
+int phase_write_json(const phase_timer *t, const grid_summary *s, const char *path) {
+    FILE *out = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return -1;
+    }
+    double total = phase_total(t);
+    double cells = (double) s->width * s->height;
+    fprintf(out, "{\"backend\": \"%s\", \"workers\": %d, \"width\": %d, \"height\": %d, "
+                 "\"kernel\": \"%s\", \"ilp\": %d, \"phases\": {",
+            s->backend, s->workers, s->width, s->height, s->kernel, s->ilp);
+    for (int p = 0; p < PHASE_COUNT; p++)
+        fprintf(out, "%s\"%s\": %.6f", p ? ", " : "", phase_names[p], t->seconds[p]);
+    fprintf(out, "}, \"total\": %.6f, \"cells_per_second\": %.0f", total,
+            t->seconds[PHASE_COMPUTE] > 0.0 ? cells / t->seconds[PHASE_COMPUTE] : 0.0);
+    if (t->has_energy) {
+        fprintf(out, ", \"joules\": {");
+        for (int p = 0; p < PHASE_COUNT; p++)
+            fprintf(out, "%s\"%s\": %.3f", p ? ", " : "", phase_names[p], t->joules[p]);
+        fprintf(out, "}, \"joules_total\": %.3f, \"joules_per_mcell\": %.6f", phase_total_joules(t),
+                cells > 0.0 ? t->joules[PHASE_COMPUTE] / (cells / 1e6) : 0.0);
+    }
+    fprintf(out, "}\n");
+    if (out == stdout) {
+        fflush(stdout);
+        return 0;
+    }
+    if (fclose(out) != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
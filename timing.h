@@ -0,0 +1,70 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <time.h>
+#include "report.h"
+#include "energy.h"
+
+// Спільний таймер для всіх драйверів: настінний час CLOCK_MONOTONIC, а не
+// clock() (процесорний час) чи власний таймер OpenMP або MPI
+static inline double wall_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef enum {
+    PHASE_ALLOC,        // виділення сітки та допоміжних буферів
+    PHASE_COMPUTE,      // обчислення рядків, включно з очікуванням на бар'єрі
+    PHASE_REDUCE,       // об'єднання min/max/відбитка між потоками чи процесами
+    PHASE_GATHER,       // збір сітки на rank 0 і запис файлів (трасування)
+    PHASE_VERIFY,
+    PHASE_OUTPUT,       // контрольні клітинки, відбиток, друк результатів
+    PHASE_COUNT
+} phase_id;
+
+// Послідовні позначки ділять час від phase_init без пропусків: кожен
+// phase_mark відносить усе, що минуло з попередньої позначки, до фази id.
+// З приєднаним лічильником енергії так само ділиться й енергія.
+typedef struct {
+    double start, mark;
+    double seconds[PHASE_COUNT];
+    energy_meter *energy;       // NULL — енергія не вимірюється
+    int has_energy;             // joules заповнені (у MPI — сума по вузлах)
+    double energy_mark;
+    double joules[PHASE_COUNT];
+} phase_timer;
+
+void phase_init(phase_timer *t);
+
+// Повертає тривалість щойно закритого відрізка
+double phase_mark(phase_timer *t, phase_id id);
+
+// Те саме з моментом, заміряним раніше (наприклад, потоком 0 на бар'єрі)
+double phase_mark_at(phase_timer *t, phase_id id, double when);
+
+static inline double phase_total(const phase_timer *t) {
+    double total = 0.0;
+    for (int p = 0; p < PHASE_COUNT; p++) total += t->seconds[p];
+    return total;
+}
+
+// Енергія від цього моменту ділиться між фазами так само, як час
+void phase_attach_energy(phase_timer *t, energy_meter *m);
+
+static inline double phase_total_joules(const phase_timer *t) {
+    double total = 0.0;
+    for (int p = 0; p < PHASE_COUNT; p++) total += t->joules[p];
+    return total;
+}
+
+// Однакова таблиця фаз для всіх драйверів
+void phase_report(const phase_timer *t);
+
+// Енергія обчислення поруч із пропускною здатністю: Дж на мільйон клітинок
+void phase_energy_report(const phase_timer *t, long long cells);
+
+// JSON-підсумок запуску з фазами; path "-" — stdout. Повертає 0 або -1.
+int phase_write_json(const phase_timer *t, const grid_summary *s, const char *path);
+
+#endif
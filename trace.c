@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+static const char *kind_names[TRACE_KINDS] = {
+    "rows", "tile", "barrier", "reduce", "verify", "gather", "output",
+};
+
+int trace_init(trace_log *log, int enabled, int threads, int pid) {
+    memset(log, 0, sizeof(*log));
+    log->threads = threads;
+    log->pid = pid;
+    if (!enabled) return 0;
+    log->rings = aligned_alloc(CACHE_LINE, threads * sizeof(trace_ring));
+    if (!log->rings) return -1;
+    for (int t = 0; t < threads; t++) {
+        log->rings[t].events = malloc(TRACE_CAPACITY * sizeof(trace_event));
+        atomic_init(&log->rings[t].head, 0);
+        if (!log->rings[t].events) {
+            log->threads = t + 1;
+            trace_free(log);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+trace_event *trace_collect(const trace_log *log, long long offset, size_t *count, long long *dropped) {
+    *count = 0;
+    *dropped = 0;
+    if (!log->rings) return NULL;
+
+    size_t total = 0;
+    for (int t = 0; t < log->threads; t++) {
+        unsigned long long head = atomic_load_explicit(&log->rings[t].head, memory_order_acquire);
+        total += head < TRACE_CAPACITY ? head : TRACE_CAPACITY;
+    }
+    trace_event *out = malloc((total ? total : 1) * sizeof(trace_event));
+    if (!out) return NULL;
+
+    for (int t = 0; t < log->threads; t++) {
+        const trace_ring *ring = &log->rings[t];
+        unsigned long long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        unsigned long long first = head > TRACE_CAPACITY ? head - TRACE_CAPACITY : 0;
+        *dropped += (long long) first;
+        for (unsigned long long k = first; k < head; k++) {
+            trace_event ev = ring->events[k & (TRACE_CAPACITY - 1)];
+            ev.pid = log->pid;
+            ev.tid = t;
+            ev.begin -= offset;
+            ev.end -= offset;
+            out[(*count)++] = ev;
+        }
+    }
+    return out;
+}
+
+int trace_write(const char *path, const char *backend, const trace_event *events, size_t count) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return -1;
+    }
+
+    long long origin = count ? events[0].begin : 0, last = origin;
+    int max_pid = 0;
+    for (size_t k = 0; k < count; k++) {
+        if (events[k].begin < origin) origin = events[k].begin;
+        if (events[k].end > last) last = events[k].end;
+        if (events[k].pid > max_pid) max_pid = events[k].pid;
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int p = 0; p <= max_pid; p++)
+        fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                     "\"args\":{\"name\":\"%s %d\"}},\n", p, backend, p);
+    // Повні події ("ph":"X"): початок і тривалість у мікросекундах
+    for (size_t k = 0; k < count; k++) {
+        const trace_event *ev = &events[k];
+        fprintf(out, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                     "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"arg\":%lld",
+                kind_names[ev->kind], backend, ev->pid, ev->tid,
+                (ev->begin - origin) / 1e3, (ev->end - ev->begin) / 1e3, ev->arg);
+        if (ev->kind == TRACE_ROWS || ev->kind == TRACE_TILE) fprintf(out, ",\"rows\":%d", ev->count);
+        fprintf(out, "}},\n");
+    }
+    // Кінцевий запис без коми після себе: JSON не допускає висячої коми
+    fprintf(out, "{\"name\":\"trace_end\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}\n]}\n",
+            (last - origin) / 1e3);
+
+    if (fclose(out) != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int trace_finish(trace_log *log, const char *path, const char *backend) {
+    if (!log->rings) return 0;
+    size_t count;
+    long long dropped;
+    trace_event *events = trace_collect(log, 0, &count, &dropped);
+    int rc = events ? trace_write(path, backend, events, count) : -1;
+    if (dropped)
+        fprintf(stderr, "Трасування: перезаписано %lld найстаріших подій\n", dropped);
+    free(events);
+    trace_free(log);
+    return rc;
+}
+
+void trace_free(trace_log *log) {
+    if (log->rings) {
+        for (int t = 0; t < log->threads; t++) free(log->rings[t].events);
+        free(log->rings);
+    }
+    log->rings = NULL;
+}
@@ -0,0 +1,87 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <time.h>
+#include "thread_stats.h"
+
+// Подій на потік до переповнення; далі найстаріші перезаписуються
+#define TRACE_CAPACITY (1u << 16)
+
+typedef enum {
+    TRACE_ROWS,         // неперервний діапазон рядків, arg — перший рядок
+    TRACE_TILE,         // плитка taskloop чи розкладки, arg — номер плитки, count — її рядки
+    TRACE_BARRIER,      // очікування інших потоків після циклу
+    TRACE_REDUCE,       // об'єднання min/max/відбитка
+    TRACE_VERIFY,
+    TRACE_GATHER,       // збір сітки на rank 0
+    TRACE_OUTPUT,       // друк результатів
+    TRACE_KINDS
+} trace_kind;
+
+// Фіксований розмір без вказівників, щоб події можна було переслати як MPI_BYTE
+typedef struct {
+    int kind;
+    int pid;            // номер процесу MPI, 0 для seq та openmp
+    int tid;
+    int count;          // рядків у діапазоні, 0 для інших подій
+    long long begin;    // нс, CLOCK_MONOTONIC
+    long long end;
+    long long arg;
+} trace_event;
+
+// Кільце одного потоку. Пише лише власник: подія заповнюється, потім head
+// публікується release-записом, тож читач після acquire бачить цілі події.
+typedef struct {
+    trace_event *events;
+    _Atomic unsigned long long head;    // подій записано від початку
+} __attribute__((aligned(CACHE_LINE))) trace_ring;
+
+typedef struct {
+    trace_ring *rings;      // NULL — трасування вимкнено
+    int threads;
+    int pid;
+} trace_log;
+
+static inline long long trace_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline trace_ring *trace_thread(const trace_log *log, int tid) {
+    return log->rings ? &log->rings[tid] : NULL;
+}
+
+static inline void trace_record(trace_ring *ring, trace_kind kind, long long begin,
+                                long long end, long long arg, int count) {
+    if (!ring) return;
+    unsigned long long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    trace_event *ev = &ring->events[head & (TRACE_CAPACITY - 1)];
+    ev->kind = kind;
+    ev->count = count;
+    ev->begin = begin;
+    ev->end = end;
+    ev->arg = arg;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+// enabled = 0 лишає журнал порожнім, і trace_thread повертає NULL.
+// Повертає 0 або -1.
+int trace_init(trace_log *log, int enabled, int threads, int pid);
+
+// Копіює події всіх кілець у новий масив, віднімаючи offset від міток часу
+// (поправка годинника процесу відносно rank 0). Викликати після того, як
+// потоки-власники завершили запис. *dropped — перезаписані події.
+trace_event *trace_collect(const trace_log *log, long long offset, size_t *count, long long *dropped);
+
+// Chrome/Perfetto trace JSON; мітки часу відлічуються від найранішої події
+int trace_write(const char *path, const char *backend, const trace_event *events, size_t count);
+
+// Для однопроцесних драйверів: зібрати, записати у path і звільнити журнал
+int trace_finish(trace_log *log, const char *path, const char *backend);
+
+void trace_free(trace_log *log);
+
+#endif
@@ -0,0 +1,270 @@
+#include <stdatomic.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "workpool.h"
+#include "thread_stats.h"
+#include "timing.h"
+
+// Дека Чейза-Лева з порядками пам'яті за Lê, Pop, Cohen, Zappa Nardelli
+// (PPoPP 2013). Розмір не змінюється під час запуску: workpool_run
+// заповнює деки до того, як розбудить виконавців, а задачі нових не додають.
+typedef struct {
+    _Atomic long top;           // звідси крадуть інші
+    _Atomic long bottom;        // звідси бере власник
+    _Atomic long *buffer;
+    long capacity;              // степінь двійки
+} __attribute__((aligned(CACHE_LINE))) ws_deque;
+
+#define DEQUE_EMPTY (-1)
+#define DEQUE_ABORT (-2)
+
+typedef struct {
+    workpool *pool;
+    int id;
+    unsigned int seed;          // вибір жертви для крадіжки
+    double idle_since;          // коли красти стало нічого
+    long spill_first, spill_last;   // блок, під який не вистачило деки
+    workpool_stats stats;
+} __attribute__((aligned(CACHE_LINE))) pool_worker;
+
+struct workpool {
+    int workers;
+    ws_deque *deques;
+    pool_worker *info;
+    pthread_t *threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // новий запуск або завершення пулу
+    pthread_cond_t done;        // усі виконавці вийшли з запуску
+    unsigned long generation;   // номер запуску, під lock
+    int active;                 // виконавців усередині запуску, під lock
+    int shutdown;
+    int each;                   // запуск workpool_each: task один раз у кожному потоці
+
+    pool_task task;
+    void *ctx;
+};
+
+static int deque_reserve(ws_deque *d, long count) {
+    long capacity = 1;
+    while (capacity < count) capacity <<= 1;
+    if (capacity > d->capacity) {
+        _Atomic long *buffer = realloc(d->buffer, capacity * sizeof(*buffer));
+        if (!buffer) return -1;
+        d->buffer = buffer;
+        d->capacity = capacity;
+    }
+    return 0;
+}
+
+// Лише власник
+static long deque_take(ws_deque *d) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return DEQUE_EMPTY;
+    }
+    long x = atomic_load_explicit(&d->buffer[b & (d->capacity - 1)], memory_order_relaxed);
+    if (t == b) {
+        // Останній елемент: змагаємося з крадіями за top
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed))
+            x = DEQUE_EMPTY;
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return x;
+}
+
+// Будь-який інший потік
+static long deque_steal(ws_deque *d) {
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return DEQUE_EMPTY;
+    long x = atomic_load_explicit(&d->buffer[t & (d->capacity - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return DEQUE_ABORT;
+    return x;
+}
+
+// Обхід усіх чужих дек з випадкової; повертає задачу або DEQUE_EMPTY,
+// якщо за повний обхід без конфліктів нічого не знайдено
+static long steal_any(pool_worker *w) {
+    workpool *pool = w->pool;
+    for (;;) {
+        int aborted = 0;
+        int start = (int) (rand_r(&w->seed) % (unsigned) pool->workers);
+        for (int k = 0; k < pool->workers; k++) {
+            int victim = (start + k) % pool->workers;
+            if (victim == w->id) continue;
+            long x = deque_steal(&pool->deques[victim]);
+            if (x >= 0) return x;
+            if (x == DEQUE_ABORT) aborted = 1;
+        }
+        if (!aborted) return DEQUE_EMPTY;
+    }
+}
+
+static void *worker_main(void *arg) {
+    pool_worker *w = arg;
+    workpool *pool = w->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->shutdown)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        int each = pool->each;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (each) {
+            pool->task(pool->ctx, w->id, w->id);
+        } else {
+            // Задачі нових задач не створюють, тож коли порожні всі деки,
+            // роботи в цьому запуску більше не буде
+            ws_deque *own = &pool->deques[w->id];
+            for (;;) {
+                long x = deque_take(own);
+                if (x == DEQUE_EMPTY) {
+                    x = steal_any(w);
+                    if (x == DEQUE_EMPTY) break;
+                    w->stats.steals++;
+                }
+                pool->task(pool->ctx, x, w->id);
+                w->stats.tasks++;
+            }
+            w->idle_since = wall_now();
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+workpool *workpool_create(int workers) {
+    if (workers < 1) return NULL;
+    workpool *pool = calloc(1, sizeof(workpool));
+    if (!pool) return NULL;
+    pool->workers = workers;
+    pool->deques = aligned_alloc(CACHE_LINE, workers * sizeof(ws_deque));
+    pool->info = aligned_alloc(CACHE_LINE, workers * sizeof(pool_worker));
+    pool->threads = calloc(workers, sizeof(pthread_t));
+    if (!pool->deques || !pool->info || !pool->threads) {
+        free(pool->deques);
+        free(pool->info);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    memset(pool->deques, 0, workers * sizeof(ws_deque));
+    memset(pool->info, 0, workers * sizeof(pool_worker));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (int w = 0; w < workers; w++) {
+        pool->info[w].pool = pool;
+        pool->info[w].id = w;
+        pool->info[w].seed = 0x9E3779B9u * (unsigned) (w + 1);
+        if (pthread_create(&pool->threads[w], NULL, worker_main, &pool->info[w]) != 0) {
+            pool->workers = w;
+            workpool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+int workpool_size(const workpool *pool) {
+    return pool->workers;
+}
+
+// Будить виконавців на новий запуск і чекає, поки всі з нього вийдуть
+static void start_and_wait(workpool *pool, pool_task task, void *ctx, int each) {
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->each = each;
+    pool->active = pool->workers;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void workpool_run(workpool *pool, long count, pool_task task, void *ctx) {
+    if (count <= 0) return;
+    // Блоки рядків підряд: власник іде по своєму блоку згори вниз, а крадії
+    // забирають з протилежного кінця, подалі від нього
+    long per_worker = (count + pool->workers - 1) / pool->workers;
+    for (int w = 0; w < pool->workers; w++) {
+        ws_deque *d = &pool->deques[w];
+        long first = w * per_worker < count ? w * per_worker : count;
+        long last = first + per_worker < count ? first + per_worker : count;
+        pool->info[w].spill_first = pool->info[w].spill_last = 0;
+        if (deque_reserve(d, per_worker) != 0) {
+            // Без пам'яті під деку блок виконується після запуску в цьому потоці
+            pool->info[w].spill_first = first;
+            pool->info[w].spill_last = last;
+            last = first;
+        }
+        for (long k = 0; k < last - first; k++)
+            atomic_store_explicit(&d->buffer[k], last - 1 - k, memory_order_relaxed);
+        atomic_store_explicit(&d->top, 0, memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, last - first, memory_order_relaxed);
+        pool->info[w].stats.tasks = 0;
+        pool->info[w].stats.steals = 0;
+    }
+
+    start_and_wait(pool, task, ctx, 0);
+
+    // Виконавці сплять, тож їхні номери вільні для задач з невдалих дек
+    for (int w = 0; w < pool->workers; w++) {
+        pool_worker *info = &pool->info[w];
+        for (long x = info->spill_first; x < info->spill_last; x++) {
+            task(ctx, x, w);
+            info->stats.tasks++;
+        }
+    }
+
+    // Очікування кожного виконавця — від порожніх дек до кінця запуску
+    double end = wall_now();
+    for (int w = 0; w < pool->workers; w++)
+        pool->info[w].stats.idle = end - pool->info[w].idle_since;
+}
+
+void workpool_each(workpool *pool, pool_task task, void *ctx) {
+    start_and_wait(pool, task, ctx, 1);
+}
+
+workpool_stats workpool_worker_stats(const workpool *pool, int worker) {
+    return pool->info[worker].stats;
+}
+
+void workpool_destroy(workpool *pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int w = 0; w < pool->workers; w++) pthread_join(pool->threads[w], NULL);
+
+    for (int w = 0; w < pool->workers; w++) free(pool->deques[w].buffer);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+    free(pool->deques);
+    free(pool->info);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,41 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+// Постійний пул потоків pthreads з крадіжкою роботи, без рантайму OpenMP.
+// Задачі — номери 0..count-1; кожен виконавець отримує неперервний блок у
+// власну деку Чейза-Лева, бере з її низу, а спорожнівши, краде з верху
+// чужих дек. Між запусками і коли красти нічого, потоки сплять на умовній
+// змінній, а не крутяться.
+
+typedef struct workpool workpool;
+
+// task(ctx, номер задачі, номер виконавця 0..workers-1)
+typedef void (*pool_task)(void *ctx, long task, int worker);
+
+// NULL, якщо не вдалося створити потоки
+workpool *workpool_create(int workers);
+
+int workpool_size(const workpool *pool);
+
+// Виконує task для всіх номерів і повертається, коли всі задачі завершені.
+// Блок виконавця, деці якого не вистачило пам'яті, виконується в потоці
+// виклику після запуску з номером того ж виконавця. Викликати з одного
+// потоку за раз.
+void workpool_run(workpool *pool, long count, pool_task task, void *ctx);
+
+// task(ctx, w, w) рівно один раз у потоці кожного виконавця w — для
+// потокового стану на кшталт лічильників perf. Лічильників запуску не змінює.
+void workpool_each(workpool *pool, pool_task task, void *ctx);
+
+// Лічильники останнього запуску для виконавця
+typedef struct {
+    long long tasks;        // виконано задач
+    long long steals;       // з них украдено з чужих дек
+    double idle;            // секунд сну в очікуванні кінця запуску
+} workpool_stats;
+
+workpool_stats workpool_worker_stats(const workpool *pool, int worker);
+
+void workpool_destroy(workpool *pool);
+
+#endif